@@ -0,0 +1,278 @@
+// Benchmarks for the game engine hot paths on fixed positions.
+//
+// The batch evaluator runs over every 3x3 encoding; its nodes/s column is
+// boards per second.
+//
+// usage: tictactoe_bench [--json] [--min-ms N]
+//
+// Each benchmark reports ns/op, nodes/sec where the operation visits a
+// tree, heap allocations per op and the process peak RSS after it ran.
+// --json prints one JSON document for regression tracking.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "../include/AllocationCounter.h"
+#include "../include/BatchEval.h"
+#include "../include/Game.h"
+#include "../include/GameTree.h"
+#include "../include/SearchEngine.h"
+
+namespace {
+
+volatile long long sink;
+
+struct Position {
+    const char* name;
+    std::vector<int> moves; // cells played alternately, X first
+};
+
+const std::vector<Position> POSITIONS = {
+    {"empty", {}},
+    {"midgame", {4, 0, 2}},
+    {"near-terminal", {4, 0, 2, 6, 3}},
+};
+
+struct Result {
+    std::string name;
+    std::string position;
+    uint64_t iterations;
+    double nsPerOp;
+    double nodesPerSec;
+    double allocsPerOp;
+    long peakRssKb;
+};
+
+long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // kilobytes on Linux
+}
+
+void play(Game& game, const Position& p) {
+    game.reset();
+    for (int cell : p.moves) {
+        game.makeMove(cell / 3, cell % 3);
+        game.switchPlayer();
+    }
+}
+
+Bitboard bitboardOf(const Position& p) {
+    Bitboard b;
+    char player = 'X';
+    for (int cell : p.moves) {
+        bitsFor(b, player) |= 1u << cell;
+        player = (player == 'X') ? 'O' : 'X';
+    }
+    return b;
+}
+
+char toMove(const Position& p) {
+    return (p.moves.size() % 2) ? 'O' : 'X';
+}
+
+double secondsSince(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+// Times setup()+op() and setup() alone over the same iteration count and
+// reports the difference, so per-iteration resets do not count against op.
+// The iteration count doubles until one run takes at least minMs.
+template <class Setup, class Op>
+Result measure(const char* name, const char* position, double minMs, double nodesPerOp,
+               Setup setup, Op op) {
+    uint64_t iterations = 1;
+    double withOp = 0, setupOnly = 0;
+    uint64_t opAllocs = 0, setupAllocs = 0;
+    const AllocationCounter allocations;
+    for (;;) {
+        uint64_t a0 = allocations.count();
+        auto t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) {
+            setup();
+            op();
+        }
+        withOp = secondsSince(t0);
+        opAllocs = allocations.count() - a0;
+
+        a0 = allocations.count();
+        t0 = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) setup();
+        setupOnly = secondsSince(t0);
+        setupAllocs = allocations.count() - a0;
+
+        if (withOp * 1000 >= minMs || iterations >= (uint64_t(1) << 32)) break;
+        iterations *= 2;
+    }
+
+    double seconds = std::max(withOp - setupOnly, 1e-12);
+    Result r;
+    r.name = name;
+    r.position = position;
+    r.iterations = iterations;
+    r.nsPerOp = seconds * 1e9 / iterations;
+    r.nodesPerSec = nodesPerOp > 0 ? nodesPerOp * iterations / seconds : 0;
+    r.allocsPerOp = double(opAllocs - std::min(opAllocs, setupAllocs)) / iterations;
+    r.peakRssKb = peakRssKb();
+    return r;
+}
+
+void printText(const std::vector<Result>& results) {
+    std::printf("%-26s %-14s %12s %14s %12s %10s\n",
+                "benchmark", "position", "ns/op", "nodes/s", "allocs/op", "rss KB");
+    for (const Result& r : results) {
+        std::printf("%-26s %-14s %12.1f %14.0f %12.2f %10ld\n", r.name.c_str(), r.position.c_str(),
+                    r.nsPerOp, r.nodesPerSec, r.allocsPerOp, r.peakRssKb);
+    }
+}
+
+void printJson(const std::vector<Result>& results) {
+    std::printf("{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::printf("    {\"name\": \"%s\", \"position\": \"%s\", \"iterations\": %llu, "
+                    "\"ns_per_op\": %.3f, \"nodes_per_sec\": %.0f, \"allocs_per_op\": %.3f, "
+                    "\"peak_rss_kb\": %ld}%s\n",
+                    r.name.c_str(), r.position.c_str(), (unsigned long long)r.iterations,
+                    r.nsPerOp, r.nodesPerSec, r.allocsPerOp, r.peakRssKb,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ],\n  \"peak_rss_kb\": %ld\n}\n", peakRssKb());
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    double minMs = 100;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--json")) json = true;
+        else if (!std::strcmp(argv[i], "--min-ms") && i + 1 < argc) minMs = std::atof(argv[++i]);
+    }
+
+    std::vector<Result> results;
+    Game game;
+
+    for (const Position& p : POSITIONS) {
+        play(game, p);
+        results.push_back(measure("checkWin", p.name, minMs, 0, [] {}, [&] { sink = game.checkWin(); }));
+        results.push_back(measure("checkDraw", p.name, minMs, 0, [] {}, [&] { sink = game.checkDraw(); }));
+
+        char cells[3][3];
+        toArray(bitboardOf(p), cells);
+        results.push_back(measure("evaluateBoard", p.name, minMs, 0, [] {},
+                                  [&] { sink = game.evaluateBoard(cells); }));
+    }
+
+    for (const Position& p : POSITIONS) {
+        const Bitboard b = bitboardOf(p);
+        const char side = toMove(p);
+        GameTree counter;
+        counter.build(b, side);
+        const double treeNodes = double(counter.size());
+
+        results.push_back(measure("buildGameTree", p.name, minMs, treeNodes, [] {},
+                                  [&] { sink = game.buildGameTree(b, side)->score; }));
+
+        // Cold: the transposition table is emptied before every scoring pass
+        TreeNode* root = game.buildGameTree(b, side);
+        results.push_back(measure("minimaxTree", p.name, minMs, treeNodes,
+                                  [&] { game.clearTranspositionTables(); },
+                                  [&] { sink = game.minimaxTree(root, side == 'O'); }));
+    }
+
+    struct Backend {
+        const char* name;
+        AIMode mode;
+    };
+    const Backend backends[] = {
+        {"makeAIMove/table", AIMode::Table},
+        {"makeAIMove/tree", AIMode::Tree},
+        {"makeAIMove/search", AIMode::Search},
+        {"makeAIMove/mcts", AIMode::Mcts},
+    };
+    MctsLimits mctsLimits;
+    mctsLimits.playouts = 2000;
+    mctsLimits.timeBudgetMs = 0;
+    for (const Backend& backend : backends) {
+        for (const Position& p : POSITIONS) {
+            Game ai;
+            ai.setAIMode(backend.mode);
+            ai.setMctsLimits(mctsLimits);
+            results.push_back(measure(backend.name, p.name, minMs, 0,
+                                      [&] { play(ai, p); },
+                                      [&] { ai.makeAIMoveWithTree(); }));
+        }
+    }
+
+    // Batch evaluation: all 3^9 boards, each kernel checked against the scalar
+    // evaluateBits and hasLine/occupied first
+    {
+        BoardBatch batch;
+        for (int code = 0; code < 19683; ++code) {
+            Bitboard b;
+            for (int i = 0, rest = code; i < 9; ++i, rest /= 3) {
+                if (rest % 3 == 1) b.x |= 1u << i;
+                else if (rest % 3 == 2) b.o |= 1u << i;
+            }
+            batch.push(b);
+        }
+        const double boards = double(batch.size());
+        std::vector<int8_t> values(batch.size());
+        std::vector<GameResult> outcomes(batch.size());
+
+        results.push_back(measure("evaluateBoard loop", "all 3x3", minMs, boards, [] {}, [&] {
+            for (size_t i = 0; i < batch.size(); ++i)
+                values[i] = int8_t(game.evaluateBoard(Bitboard(batch.x[i], batch.o[i])));
+        }));
+
+        for (BatchKernel kernel : {BatchKernel::Scalar, BatchKernel::Sse2, BatchKernel::Avx2}) {
+            if (!batchKernelSupported(kernel)) continue;
+            evaluateBatch(batch, values.data(), kernel);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                if (values[i] != evaluateBits(Bitboard(batch.x[i], batch.o[i]))) {
+                    std::fprintf(stderr, "evaluateBatch/%s disagrees with evaluateBits on board %zu\n",
+                                 batchKernelName(kernel), i);
+                    return 1;
+                }
+            }
+            classifyBatch(batch, outcomes.data(), kernel);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                const Bitboard b(batch.x[i], batch.o[i]);
+                GameResult expected = hasLine(b.o) ? GameResult::OWins
+                                    : hasLine(b.x) ? GameResult::XWins
+                                    : occupied(b) == FULL_BOARD ? GameResult::Draw
+                                    : GameResult::Unfinished;
+                if (outcomes[i] != expected) {
+                    std::fprintf(stderr, "classifyBatch/%s disagrees with hasLine/occupied on board %zu\n",
+                                 batchKernelName(kernel), i);
+                    return 1;
+                }
+            }
+            std::string name = std::string("evaluateBatch/") + batchKernelName(kernel);
+            results.push_back(measure(name.c_str(), "all 3x3", minMs, boards, [] {},
+                                      [&] { evaluateBatch(batch, values.data(), kernel); }));
+        }
+        sink = values[19682];
+    }
+
+    // Alpha-beta on a board too big for the table, fixed depth, cold table
+    {
+        Board b(4, 4);
+        SearchEngine engine;
+        SearchLimits limits;
+        limits.maxDepth = 6;
+        limits.timeBudgetMs = 0;
+        SearchResult probe = engine.search(b, 'X', limits);
+        results.push_back(measure("SearchEngine 4x4k4 d6", "empty", minMs, double(probe.nodes),
+                                  [&] { engine.clear(); },
+                                  [&] { sink = engine.search(b, 'X', limits).move; }));
+    }
+
+    if (json) printJson(results);
+    else printText(results);
+    return 0;
+}
@@ -0,0 +1,253 @@
+// Load generator for the game server.
+//
+// usage: tictactoe_loadgen [--port P | --unix PATH] [--clients N] [--seconds S]
+//                          [--size N] [--win K] [--ai table|search|mcts] [--seed S]
+//                          [--games G] [--user-prefix NAME]
+//
+// Keeps N sessions open from one epoll thread. A session connects, logs in
+// as account NAME<client> (signing it up the first time; later runs reuse
+// it, so the server's user store stops growing after the first run), plays
+// G games (default 1) with random legal moves as X, and disconnects; its
+// client slot then starts the next session. Reports sessions per second,
+// the session time (connect to last game over) and the MOVE -> reply
+// latency percentiles over all moves.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Client {
+    int fd = -1;
+    std::string in;
+    std::string out;
+    std::vector<char> cells;   // ' ', 'X' or 'O'
+    int pendingReplies = 0;    // replies to skip before the game starts
+    bool waiting = false;      // a MOVE is in flight
+    int gamesLeft = 0;         // in this session, including the current one
+    Clock::time_point sentAt;
+    Clock::time_point sessionStart;
+};
+
+struct Options {
+    int port = 7777;
+    std::string unixPath;
+    int clients = 64;
+    double seconds = 5;
+    int size = 3;
+    int win = 3;
+    std::string ai = "table";
+    uint64_t seed = 1;
+    int games = 1;             // per session
+    std::string userPrefix = "load";
+};
+
+uint64_t rngState;
+
+uint64_t nextRandom() {
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+int connectTo(const Options& opt) {
+    int fd;
+    int rc;
+    if (opt.unixPath.empty()) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(opt.port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        rc = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    } else {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, opt.unixPath.c_str(), sizeof(addr.sun_path) - 1);
+        rc = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+    if (rc < 0) {
+        ::close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return fd;
+}
+
+void flushOut(Client& c) {
+    while (!c.out.empty()) {
+        ssize_t n = write(c.fd, c.out.data(), c.out.size());
+        if (n <= 0) return; // the kernel buffer is far larger than anything queued here
+        c.out.erase(0, n);
+    }
+}
+
+void newGame(Client& c, const Options& opt) {
+    std::fill(c.cells.begin(), c.cells.end(), ' ');
+    c.out += "NEW " + std::to_string(opt.size) + " " + std::to_string(opt.win) + " " + opt.ai + "\n";
+    c.pendingReplies += 1;
+}
+
+void sendMove(Client& c, const Options& opt) {
+    std::vector<int> empty;
+    for (int i = 0; i < (int)c.cells.size(); ++i)
+        if (c.cells[i] == ' ') empty.push_back(i);
+    int cell = empty[nextRandom() % empty.size()];
+    c.cells[cell] = 'X';
+    c.out += "MOVE " + std::to_string(cell / opt.size) + " " + std::to_string(cell % opt.size) + "\n";
+    c.waiting = true;
+    c.sentAt = Clock::now();
+}
+
+// Connects slot i, logs in and sends the first move; false if the server is gone
+bool startSession(Client& c, int i, const Options& opt, int epollFd) {
+    c.sessionStart = Clock::now();
+    c.fd = connectTo(opt);
+    if (c.fd < 0) return false;
+    c.in.clear();
+    c.cells.assign(opt.size * opt.size, ' ');
+    c.gamesLeft = opt.games;
+    std::string user = opt.userPrefix + std::to_string(i);
+    // Pipelined: the replies to these come back in order and are skipped;
+    // SIGNUP answers ERR taken once the account exists
+    c.out = "SIGNUP " + user + " pw\nLOGIN " + user + " pw\n";
+    c.pendingReplies = 2;
+    newGame(c, opt);
+    sendMove(c, opt);
+    flushOut(c);
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = i;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, c.fd, &ev);
+    return true;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t i = std::min(sorted.size() - 1, size_t(p * sorted.size()));
+    return sorted[i];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--port")) opt.port = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--unix")) opt.unixPath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--clients")) opt.clients = std::max(1, std::atoi(argv[i + 1]));
+        else if (!std::strcmp(argv[i], "--seconds")) opt.seconds = std::atof(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--size")) opt.size = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--win")) opt.win = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--ai")) opt.ai = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--seed")) opt.seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--games")) opt.games = std::max(1, std::atoi(argv[i + 1]));
+        else if (!std::strcmp(argv[i], "--user-prefix")) opt.userPrefix = argv[i + 1];
+    }
+    rngState = opt.seed ? opt.seed : 1;
+
+    int epollFd = epoll_create1(0);
+    std::vector<Client> clients(opt.clients);
+    auto start = Clock::now();
+    for (int i = 0; i < opt.clients; ++i) {
+        if (!startSession(clients[i], i, opt, epollFd)) {
+            std::fprintf(stderr, "connect failed\n");
+            return 1;
+        }
+    }
+
+    std::vector<double> latencies, sessionMs;
+    uint64_t games = 0, errors = 0;
+    auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.seconds));
+    std::vector<epoll_event> events(opt.clients);
+
+    while (Clock::now() < end) {
+        int n = epoll_wait(epollFd, events.data(), (int)events.size(), 50);
+        for (int e = 0; e < n; ++e) {
+            Client& c = clients[events[e].data.u32];
+            char buf[4096];
+            ssize_t got;
+            while ((got = read(c.fd, buf, sizeof(buf))) > 0) c.in.append(buf, got);
+            if (got == 0) {
+                std::fprintf(stderr, "server closed a connection\n");
+                return 1;
+            }
+
+            size_t nl;
+            while ((nl = c.in.find('\n')) != std::string::npos) {
+                std::string line = c.in.substr(0, nl);
+                c.in.erase(0, nl + 1);
+                if (c.pendingReplies > 0) {
+                    --c.pendingReplies;
+                    if (line.compare(0, 2, "OK") != 0 && line != "ERR taken") ++errors;
+                    continue;
+                }
+                if (!c.waiting) continue;
+                c.waiting = false;
+                latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - c.sentAt).count());
+
+                int row, col;
+                bool over = line.find("END") != std::string::npos;
+                if (std::sscanf(line.c_str(), "AI %d %d", &row, &col) == 2) {
+                    c.cells[row * opt.size + col] = 'O';
+                } else if (!over) {
+                    ++errors;
+                    over = true; // resynchronise with a fresh game
+                }
+                if (over) {
+                    ++games;
+                    if (--c.gamesLeft == 0) break;
+                    newGame(c, opt);
+                }
+                sendMove(c, opt);
+            }
+            if (c.gamesLeft == 0) {
+                sessionMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - c.sessionStart).count());
+                ::close(c.fd); // also drops it from the epoll set
+                if (!startSession(c, events[e].data.u32, opt, epollFd)) {
+                    std::fprintf(stderr, "reconnect failed\n");
+                    return 1;
+                }
+                continue;
+            }
+            flushOut(c);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (Client& c : clients) ::close(c.fd);
+    ::close(epollFd);
+
+    std::sort(latencies.begin(), latencies.end());
+    std::sort(sessionMs.begin(), sessionMs.end());
+    std::printf("clients %d, %s %dx%d k%d, %d game(s) per session, %.1f s\n", opt.clients, opt.ai.c_str(),
+                opt.size, opt.size, opt.win, opt.games, elapsed);
+    std::printf("sessions %zu (%.1f/s), games %llu, moves %zu, errors %llu\n", sessionMs.size(),
+                sessionMs.size() / elapsed, (unsigned long long)games, latencies.size(),
+                (unsigned long long)errors);
+    std::printf("session ms: p50 %.1f  p99 %.1f  max %.1f\n", percentile(sessionMs, 0.50),
+                percentile(sessionMs, 0.99), sessionMs.empty() ? 0.0 : sessionMs.back());
+    std::printf("latency us: p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %.0f\n",
+                percentile(latencies, 0.50), percentile(latencies, 0.90), percentile(latencies, 0.99),
+                percentile(latencies, 0.999), latencies.empty() ? 0.0 : latencies.back());
+    return 0;
+}
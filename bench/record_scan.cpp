@@ -0,0 +1,92 @@
+// Scans a game record file in place and prints what matched.
+//
+// usage: tictactoe_records FILE [--result x|o|draw] [--size N] [--player ID]
+//                          [--min-moves M] [--replay] [--print N]
+//
+// Filters combine with AND. --replay plays every matching game onto a Board
+// and checks the stored result, --print shows the first N matches as cell
+// lists. The summary reports records/s and MB/s over the whole file.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include "../include/GameRecord.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s FILE [--result x|o|draw] [--size N] [--player ID] "
+                             "[--min-moves M] [--replay] [--print N]\n", argv[0]);
+        return 2;
+    }
+    int wantResult = -1, wantSize = 0, minMoves = 0, print = 0;
+    long long wantPlayer = -1;
+    bool replay = false;
+    for (int i = 2; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--replay")) replay = true;
+        else if (i + 1 >= argc) break;
+        else if (!std::strcmp(argv[i], "--result")) {
+            const char* r = argv[++i];
+            wantResult = !std::strcmp(r, "x") ? int(GameResult::XWins)
+                       : !std::strcmp(r, "o") ? int(GameResult::OWins)
+                       : int(GameResult::Draw);
+        }
+        else if (!std::strcmp(argv[i], "--size")) wantSize = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--player")) wantPlayer = std::atoll(argv[++i]);
+        else if (!std::strcmp(argv[i], "--min-moves")) minMoves = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--print")) print = std::atoi(argv[++i]);
+    }
+
+    GameRecordReader reader(argv[1]);
+    if (!reader.isOpen()) {
+        std::fprintf(stderr, "%s\n", reader.error().c_str());
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t total = 0, matched = 0, bad = 0, moves = 0;
+    uint64_t byResult[4] = {};
+    std::unique_ptr<Board> board;
+
+    for (const RecordView& r : reader) {
+        ++total;
+        if (wantResult >= 0 && int(r.result()) != wantResult) continue;
+        if (wantSize && r.size() != wantSize) continue;
+        if (wantPlayer >= 0 && r.playerX() != uint32_t(wantPlayer) && r.playerO() != uint32_t(wantPlayer))
+            continue;
+        if (r.moveCount() < minMoves) continue;
+
+        ++matched;
+        ++byResult[int(r.result())];
+        moves += r.moveCount();
+
+        if (replay) {
+            if (!board || board->size() != r.size() || board->winLength() != r.winLength())
+                board.reset(new Board(r.size(), r.winLength()));
+            GameResult actual = GameResult::Unfinished;
+            bool legal = r.replay(*board);
+            if (board->hasWon('X')) actual = GameResult::XWins;
+            else if (board->hasWon('O')) actual = GameResult::OWins;
+            else if (board->isFull()) actual = GameResult::Draw;
+            if (!legal || actual != r.result()) ++bad;
+        }
+        if (print > 0) {
+            --print;
+            std::printf("%dx%d k%d players %u/%u result %d:", r.size(), r.size(), r.winLength(),
+                        r.playerX(), r.playerO(), int(r.result()));
+            for (int i = 0; i < r.moveCount(); ++i) std::printf(" %d", r.move(i));
+            std::printf("\n");
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("records %llu, matched %llu (X %llu, O %llu, draw %llu, unfinished %llu), moves %llu\n",
+                (unsigned long long)total, (unsigned long long)matched,
+                (unsigned long long)byResult[1], (unsigned long long)byResult[2],
+                (unsigned long long)byResult[3], (unsigned long long)byResult[0],
+                (unsigned long long)moves);
+    if (replay) std::printf("replay mismatches %llu\n", (unsigned long long)bad);
+    std::printf("%.3f s, %.0f records/s, %.1f MB/s\n", seconds, seconds > 0 ? total / seconds : 0.0,
+                seconds > 0 ? reader.fileBytes() / seconds / 1e6 : 0.0);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+// Parallel search scaling: runs fixed-depth searches on a set of positions
+// with 1, 2, 4, ... N threads and prints the speedup over one thread. The
+// 1-thread row is the plain serial search. Threads share one table, so the
+// parallel rows vary a little between runs; "same" says whether they still
+// picked the serial move.
+//
+// usage: search_scaling [maxThreads]
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "../include/Board.h"
+#include "../include/SearchEngine.h"
+
+struct Position {
+    const char* name;
+    int size;
+    int winLength;
+    int depth;
+    std::vector<int> moves; // played alternately, X first
+};
+
+static Board setup(const Position& p, char& toMove) {
+    Board b(p.size, p.winLength);
+    toMove = 'X';
+    for (int cell : p.moves) {
+        b.place(cell, toMove);
+        toMove = (toMove == 'X') ? 'O' : 'X';
+    }
+    return b;
+}
+
+int main(int argc, char* argv[]) {
+    int maxThreads = argc > 1 ? std::atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+    if (maxThreads < 1) maxThreads = 1;
+
+    const std::vector<Position> positions = {
+        {"4x4 k4 empty", 4, 4, 8, {}},
+        {"5x5 k4 opening", 5, 4, 7, {12, 6}},
+        {"7x7 k5 midgame", 7, 5, 5, {24, 25, 17, 31, 18}},
+    };
+
+    std::vector<int> threadCounts;
+    for (int t = 1; t <= maxThreads; t *= 2) threadCounts.push_back(t);
+    if (threadCounts.back() != maxThreads) threadCounts.push_back(maxThreads);
+
+    std::printf("%-16s %7s %10s %12s %8s %5s\n", "position", "threads", "ms", "nodes", "speedup", "same");
+    for (const Position& p : positions) {
+        double serialMs = 0;
+        int serialMove = -1;
+        for (int t : threadCounts) {
+            char toMove;
+            Board b = setup(p, toMove);
+            SearchEngine engine;
+            SearchLimits limits;
+            limits.maxDepth = p.depth;
+            limits.timeBudgetMs = 0;
+            limits.threads = t;
+            SearchResult r = engine.search(b, toMove, limits);
+            if (t == 1) {
+                serialMs = r.elapsedMs;
+                serialMove = r.move;
+            }
+            std::printf("%-16s %7d %10.1f %12llu %8.2f %5s\n", p.name, t, r.elapsedMs,
+                        (unsigned long long)r.nodes, serialMs / r.elapsedMs,
+                        r.move == serialMove ? "yes" : "NO");
+        }
+    }
+    return 0;
+}
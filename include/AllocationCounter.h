@@ -0,0 +1,25 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Counts the heap allocations the calling thread makes while an instance is
+// alive. src/AllocationCounter.cpp replaces operator new for every program
+// linking the core library; the count is thread_local and only advances
+// while the thread has a counter open, so other threads, and this one
+// outside a measured region, pay one thread-local test per allocation and
+// are never charged to the measurement. Counters nest.
+class AllocationCounter {
+public:
+    AllocationCounter();
+    ~AllocationCounter();
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    uint64_t count() const; // this thread's allocations since construction
+
+private:
+    uint64_t start;
+};
+
+#endif // ALLOCATIONCOUNTER_H
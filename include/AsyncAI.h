@@ -0,0 +1,92 @@
+#ifndef ASYNCAI_H
+#define ASYNCAI_H
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Game.h"
+#include "Telemetry.h"
+
+struct PonderStats {
+    uint64_t hits = 0;    // reply already searched, answered at once
+    uint64_t joined = 0;  // reply being searched, waited for the rest
+    uint64_t misses = 0;  // searched from scratch
+    uint64_t pondered = 0; // replies searched ahead of time
+};
+
+// Runs a Game's AI moves on a background thread and ponders while the
+// human is to move.
+//
+// startPondering() snapshots the position and searches the AI's answer to
+// each likely human reply (empty cells nearest the stones first) on a
+// private copy of the game, so the real game is never touched. When
+// requestMove() comes after the human's move, an answer found for that
+// reply is played at once; if that reply is being searched right now the
+// search is left to finish; otherwise pondering is cancelled and the game
+// searches normally. The private game keeps its tables between ponders.
+//
+// With telemetry set on the game, every ponder search is reported with
+// Telemetry::recordPonder, and a pondered answer that gets played is
+// reported as that game's AI move, marked pondered.
+//
+// While a request is pending the caller must not touch the game. Pondering
+// only reads it inside startPondering() and requestMove().
+class AsyncAI {
+public:
+    explicit AsyncAI(Game& game);
+    ~AsyncAI(); // cancels whatever runs and joins the thread
+
+    AsyncAI(const AsyncAI&) = delete;
+    AsyncAI& operator=(const AsyncAI&) = delete;
+
+    void startPondering(); // the human is to move in the game; cheap to repeat
+    void stopPondering();
+
+    // The future yields the cell the AI played, once it is on the board
+    std::future<int> requestMove();
+
+    // Ends a pending request early: the best move found so far is played
+    void cancel();
+
+    PonderStats stats() const;
+
+private:
+    enum class Task { Idle, Ponder, Move, JoinPonder };
+
+    void workerLoop();
+    void ponderReply(std::unique_lock<std::mutex>& guard);
+    void runMove(std::unique_lock<std::mutex>& guard);
+    bool followsSnapshot(int reply) const;
+
+    Game& game;
+    std::unique_ptr<Game> shadow;  // only the worker thread touches it
+    Board snapshot;                // position pondered from, with the settings below
+    AIMode mode = AIMode::Table;
+    SearchLimits searchLimits;
+    MctsLimits mctsLimits;
+    Telemetry* telemetry = nullptr;
+    uint64_t generation = 0;       // bumped whenever pondered answers go stale
+    int candidates[MAX_CELLS];
+    int candidateCount = 0;
+    int nextCandidate = 0;
+    int answers[MAX_CELLS];        // AI reply per human reply, -1 if not searched
+    AIMode answerBackends[MAX_CELLS]; // with telemetry: how each answer was found
+    MoveStats answerStats[MAX_CELLS];
+    int current = -1;              // human reply being pondered now
+
+    Task task = Task::Idle;
+    bool quit = false;
+    bool cancelRequested = false;
+    std::promise<int> pending;
+    std::atomic<bool> stopSearch{false};
+    PonderStats counters;
+
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    std::thread worker;
+};
+
+#endif // ASYNCAI_H
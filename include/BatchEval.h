@@ -0,0 +1,53 @@
+#ifndef BATCHEVAL_H
+#define BATCHEVAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Bitboard.h"
+#include "GameRecord.h"
+
+// Many 3x3 boards in structure-of-arrays form: board i is (x[i], o[i]) with
+// the Bitboard bit layout. Keeping each player's masks contiguous lets the
+// kernels load 8 (SSE2) or 16 (AVX2) boards per instruction.
+struct BoardBatch {
+    std::vector<uint16_t> x;
+    std::vector<uint16_t> o;
+
+    void push(const Bitboard& b) {
+        x.push_back(b.x);
+        o.push_back(b.o);
+    }
+    void clear() {
+        x.clear();
+        o.clear();
+    }
+    size_t size() const { return x.size(); }
+};
+
+enum class BatchKernel { Auto, Scalar, Sse2, Avx2 };
+
+// The kernel Auto resolves to on this CPU, picked once with
+// __builtin_cpu_supports; Scalar on non-x86 builds
+BatchKernel bestBatchKernel();
+bool batchKernelSupported(BatchKernel kernel);
+const char* batchKernelName(BatchKernel kernel);
+
+// out[i] = evaluateBits(board i): +1 O has a line, -1 X has a line, else 0
+void evaluateBatch(const uint16_t* x, const uint16_t* o, size_t count, int8_t* out,
+                   BatchKernel kernel = BatchKernel::Auto);
+
+// out[i] = the outcome of board i: OWins or XWins if that side has a line
+// (O first, like evaluateBits), Draw if the board is full, else Unfinished
+void classifyBatch(const uint16_t* x, const uint16_t* o, size_t count, GameResult* out,
+                   BatchKernel kernel = BatchKernel::Auto);
+
+inline void evaluateBatch(const BoardBatch& batch, int8_t* out, BatchKernel kernel = BatchKernel::Auto) {
+    evaluateBatch(batch.x.data(), batch.o.data(), batch.size(), out, kernel);
+}
+
+inline void classifyBatch(const BoardBatch& batch, GameResult* out, BatchKernel kernel = BatchKernel::Auto) {
+    classifyBatch(batch.x.data(), batch.o.data(), batch.size(), out, kernel);
+}
+
+#endif // BATCHEVAL_H
@@ -0,0 +1,76 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+// 3x3 board as one bitmask per player. Bit i is cell (i / 3, i % 3).
+struct Bitboard {
+    uint16_t x;
+    uint16_t o;
+
+    constexpr Bitboard() : x(0), o(0) {}
+    constexpr Bitboard(uint16_t xBits, uint16_t oBits) : x(xBits), o(oBits) {}
+};
+
+constexpr uint16_t FULL_BOARD = 0x1FF;
+
+// Rows, columns, then the two diagonals
+constexpr uint16_t WIN_MASKS[8] = {
+    0x007, 0x038, 0x1C0,
+    0x049, 0x092, 0x124,
+    0x111, 0x054
+};
+
+constexpr int cellIndex(int row, int col) {
+    return row * 3 + col;
+}
+
+constexpr uint16_t occupied(const Bitboard& b) {
+    return b.x | b.o;
+}
+
+constexpr bool hasLine(uint16_t bits) {
+    for (uint16_t mask : WIN_MASKS)
+        if ((bits & mask) == mask) return true;
+    return false;
+}
+
+inline uint16_t& bitsFor(Bitboard& b, char player) {
+    return (player == 'X') ? b.x : b.o;
+}
+
+inline uint16_t bitsFor(const Bitboard& b, char player) {
+    return (player == 'X') ? b.x : b.o;
+}
+
+inline char cellAt(const Bitboard& b, int idx) {
+    uint16_t bit = 1u << idx;
+    if (b.x & bit) return 'X';
+    if (b.o & bit) return 'O';
+    return ' ';
+}
+
+// +1 if O has a line, -1 if X has a line, 0 otherwise (same convention as evaluateBoard)
+constexpr int evaluateBits(const Bitboard& b) {
+    if (hasLine(b.o)) return 1;
+    if (hasLine(b.x)) return -1;
+    return 0;
+}
+
+inline Bitboard toBitboard(char b[3][3]) {
+    Bitboard bb;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j) {
+            if (b[i][j] == 'X') bb.x |= 1u << cellIndex(i, j);
+            else if (b[i][j] == 'O') bb.o |= 1u << cellIndex(i, j);
+        }
+    return bb;
+}
+
+inline void toArray(const Bitboard& bb, char b[3][3]) {
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            b[i][j] = cellAt(bb, cellIndex(i, j));
+}
+
+#endif // BITBOARD_H
@@ -0,0 +1,168 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cstdint>
+#include <vector>
+
+constexpr int MAX_BOARD_SIZE = 16;
+constexpr int MAX_CELLS = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+constexpr int BOARD_WORDS = MAX_CELLS / 64;
+constexpr int MAX_WINDOWS = 4 * MAX_CELLS; // at most one window per cell and direction
+
+// One bit per cell, cell index = row * size + col
+struct BoardMask {
+    uint64_t w[BOARD_WORDS];
+
+    bool test(int cell) const { return (w[cell >> 6] >> (cell & 63)) & 1; }
+    void set(int cell) { w[cell >> 6] |= uint64_t(1) << (cell & 63); }
+    void reset(int cell) { w[cell >> 6] &= ~(uint64_t(1) << (cell & 63)); }
+    bool any() const {
+        uint64_t bits = 0;
+        for (uint64_t word : w) bits |= word;
+        return bits != 0;
+    }
+
+    BoardMask& operator|=(const BoardMask& m) {
+        for (int i = 0; i < BOARD_WORDS; ++i) w[i] |= m.w[i];
+        return *this;
+    }
+    BoardMask& operator&=(const BoardMask& m) {
+        for (int i = 0; i < BOARD_WORDS; ++i) w[i] &= m.w[i];
+        return *this;
+    }
+};
+
+// Zobrist keys per player and cell, shared by every board type so equal
+// positions hash equally
+struct ZobristTable {
+    uint64_t keys[2][MAX_CELLS];
+};
+
+constexpr ZobristTable buildZobrist() {
+    ZobristTable t{};
+    uint64_t state = 0x7474745A4F425249ull;
+    for (int p = 0; p < 2; ++p) {
+        for (int c = 0; c < MAX_CELLS; ++c) { // splitmix64
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            t.keys[p][c] = z ^ (z >> 31);
+        }
+    }
+    return t;
+}
+
+inline constexpr ZobristTable ZOBRIST = buildZobrist();
+
+// How BoardGeometry and FixedGeometry lay out a board. Both are built from
+// these, so a Board and a FixedBoard holding the same stones agree on every
+// window index and hash.
+//
+// Windows go by direction (row, column, diagonal, anti-diagonal), then by
+// first cell; visit(window, cell) is called for each cell of each window.
+// Returns the number of windows.
+template <typename Visit>
+constexpr int forEachWindowCell(int size, int winLength, Visit&& visit) {
+    int window = 0;
+    const int dirs[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+    for (auto& d : dirs) {
+        for (int r = 0; r < size; ++r) {
+            for (int c = 0; c < size; ++c) {
+                int endR = r + d[0] * (winLength - 1);
+                int endC = c + d[1] * (winLength - 1);
+                if (endR < 0 || endR >= size || endC < 0 || endC >= size) continue;
+                for (int k = 0; k < winLength; ++k)
+                    visit(window, (r + d[0] * k) * size + (c + d[1] * k));
+                ++window;
+            }
+        }
+    }
+    return window;
+}
+
+// Where cell lands under symmetry s: rotated 90 degrees s & 3 times, then
+// mirrored if s & 4
+constexpr int symmetricCell(int size, int s, int cell) {
+    int r = cell / size, c = cell % size;
+    for (int k = 0; k < (s & 3); ++k) {
+        int tmp = r;
+        r = c;
+        c = size - 1 - tmp;
+    }
+    if (s & 4) c = size - 1 - c;
+    return r * size + c;
+}
+
+// visit(near) for every cell at most two rows and columns from cell, itself
+// included; large-board searches only consider those around the stones
+template <typename Visit>
+constexpr void forEachNearCell(int size, int cell, Visit&& visit) {
+    const int r0 = cell / size, c0 = cell % size;
+    for (int r = r0 - 2; r <= r0 + 2; ++r)
+        for (int c = c0 - 2; c <= c0 + 2; ++c)
+            if (r >= 0 && r < size && c >= 0 && c < size) visit(r * size + c);
+}
+
+// Everything about an N x N, K-in-a-row board that does not change during a
+// game. One instance per (size, winLength) is shared by all boards.
+struct BoardGeometry {
+    int size;
+    int winLength;
+    int cells;
+    int windowCount;                    // every run of winLength cells, in any direction
+    std::vector<uint16_t> cellWindows;  // windows through each cell, grouped by cell
+    uint16_t cellWindowStart[MAX_CELLS + 1];
+    uint8_t symmetry[8][MAX_CELLS];     // cell -> cell under each rotation/reflection
+    uint8_t inverse[8][MAX_CELLS];
+    BoardMask cellMask;                 // every cell of the board
+    BoardMask nearMask[MAX_CELLS];      // see forEachNearCell
+
+    static const BoardGeometry& get(int size, int winLength);
+};
+
+// N x N board with K-in-a-row wins, up to 16 x 16. Keeps a Zobrist hash for
+// each of the 8 symmetries so the canonical hash is available in O(1), and a
+// stone count per player for every window, updated by place() and remove(),
+// so win and draw checks never rescan the board.
+class Board {
+public:
+    Board(int size = 3, int winLength = 3);
+    // Copies only the window counters the geometry uses, not all of MAX_WINDOWS
+    Board(const Board& other) { *this = other; }
+    Board& operator=(const Board& other);
+
+    int size() const { return geo->size; }
+    int winLength() const { return geo->winLength; }
+    int cellCount() const { return geo->cells; }
+    int moveCount() const { return moves; }
+    const BoardGeometry& geometry() const { return *geo; }
+
+    char at(int cell) const;
+    bool isEmpty(int cell) const { return !x.test(cell) && !o.test(cell); }
+    bool isFull() const { return moves == geo->cells; }
+    const BoardMask& bits(char player) const { return player == 'X' ? x : o; }
+    BoardMask empties() const;
+
+    void place(int cell, char player);
+    void remove(int cell);
+    void clear(); // empty board, same geometry
+
+    bool isWinningMove(int cell) const; // does the stone on cell complete a run?
+    bool hasWon(char player) const { return completed[player == 'X' ? 0 : 1] > 0; }
+    int windowStones(char player, int window) const { return lineCount[player == 'X' ? 0 : 1][window]; }
+
+    uint64_t hash(int symmetry = 0) const { return hashes[symmetry]; }
+    int canonicalSymmetry() const;      // symmetry giving the smallest hash
+    uint64_t canonicalHash() const { return hashes[canonicalSymmetry()]; }
+
+private:
+    const BoardGeometry* geo;
+    BoardMask x;
+    BoardMask o;
+    uint64_t hashes[8];
+    int moves;
+    uint8_t lineCount[2][MAX_WINDOWS];  // stones per player in each window
+    int completed[2];                   // windows a player fills completely
+};
+
+#endif // BOARD_H
@@ -0,0 +1,162 @@
+#ifndef FIXEDBOARD_H
+#define FIXEDBOARD_H
+
+#include <cstdint>
+#include "Board.h"
+
+// The tables of BoardGeometry for one N x N, K-in-a-row board, built at
+// compile time from the same generators (see forEachWindowCell), so a
+// FixedBoard and a Board holding the same stones agree on every window
+// count and hash.
+template <int N, int K>
+struct FixedGeometry {
+    static constexpr int CELLS = N * N;
+    static constexpr int WINDOWS = 2 * N * (N - K + 1) + 2 * (N - K + 1) * (N - K + 1);
+    static constexpr int MAX_THROUGH = 4 * K; // windows through one cell
+
+    int windowCount = WINDOWS;
+    uint64_t windowMask[WINDOWS] = {};
+    uint8_t cellWindows[CELLS][MAX_THROUGH] = {};
+    uint8_t cellWindowCount[CELLS] = {};
+    uint8_t symmetry[8][CELLS] = {};
+    uint8_t inverse[8][CELLS] = {};
+    uint64_t nearMask[CELLS] = {}; // see forEachNearCell
+};
+
+template <int N, int K>
+constexpr FixedGeometry<N, K> buildFixedGeometry() {
+    FixedGeometry<N, K> g{};
+    forEachWindowCell(N, K, [&](int window, int cell) {
+        g.windowMask[window] |= uint64_t(1) << cell;
+        g.cellWindows[cell][g.cellWindowCount[cell]++] = uint8_t(window);
+    });
+    for (int s = 0; s < 8; ++s) {
+        for (int cell = 0; cell < N * N; ++cell) {
+            int image = symmetricCell(N, s, cell);
+            g.symmetry[s][cell] = uint8_t(image);
+            g.inverse[s][image] = uint8_t(cell);
+        }
+    }
+    for (int cell = 0; cell < N * N; ++cell)
+        forEachNearCell(N, cell, [&](int near) { g.nearMask[cell] |= uint64_t(1) << near; });
+    return g;
+}
+
+// Board with the size and win length fixed at compile time, up to 8 x 8 so
+// each player's stones fit one word. Same interface and bookkeeping as
+// Board, but every table is a constexpr and every bound a constant, so the
+// search instantiated on it compiles to straight-line code per size. It is
+// also small and trivially copyable, which makes per-thread copies cheap.
+template <int N, int K>
+class FixedBoard {
+    static_assert(N >= 1 && N * N <= 64, "FixedBoard holds at most 64 cells");
+    static_assert(K >= 1 && K <= N, "win length must fit the board");
+    static_assert(FixedGeometry<N, K>::WINDOWS <= 256, "window indices are one byte");
+
+public:
+    using Geometry = FixedGeometry<N, K>;
+    static constexpr Geometry GEO = buildFixedGeometry<N, K>();
+    static constexpr uint64_t FULL = N * N == 64 ? ~uint64_t(0) : (uint64_t(1) << (N * N)) - 1;
+
+    FixedBoard() = default;
+    explicit FixedBoard(const Board& board) { // board must be N x N with win length K
+        for (int c = 0; c < N * N; ++c)
+            if (!board.isEmpty(c)) place(c, board.at(c));
+    }
+
+    static constexpr int size() { return N; }
+    static constexpr int winLength() { return K; }
+    static constexpr int cellCount() { return N * N; }
+    static constexpr const Geometry& geometry() { return GEO; }
+    int moveCount() const { return moves; }
+
+    char at(int cell) const {
+        if ((x >> cell) & 1) return 'X';
+        if ((o >> cell) & 1) return 'O';
+        return ' ';
+    }
+    bool isEmpty(int cell) const { return !(((x | o) >> cell) & 1); }
+    bool isFull() const { return moves == N * N; }
+    uint64_t bits(char player) const { return player == 'X' ? x : o; }
+    uint64_t empties() const { return ~(x | o) & FULL; }
+
+    void place(int cell, char player) {
+        const int p = (player == 'X') ? 0 : 1;
+        (p == 0 ? x : o) |= uint64_t(1) << cell;
+        for (int s = 0; s < 8; ++s)
+            hashes[s] ^= ZOBRIST.keys[p][GEO.symmetry[s][cell]];
+        ++moves;
+        for (int i = 0; i < GEO.cellWindowCount[cell]; ++i)
+            if (++lineCount[p][GEO.cellWindows[cell][i]] == K) ++completed[p];
+    }
+
+    void remove(int cell) {
+        const uint64_t bit = uint64_t(1) << cell;
+        int p;
+        if (x & bit) p = 0;
+        else if (o & bit) p = 1;
+        else return;
+
+        (p == 0 ? x : o) &= ~bit;
+        for (int s = 0; s < 8; ++s)
+            hashes[s] ^= ZOBRIST.keys[p][GEO.symmetry[s][cell]];
+        --moves;
+        for (int i = 0; i < GEO.cellWindowCount[cell]; ++i)
+            if (lineCount[p][GEO.cellWindows[cell][i]]-- == K) --completed[p];
+    }
+
+    bool isWinningMove(int cell) const {
+        const uint64_t bits = ((x >> cell) & 1) ? x : ((o >> cell) & 1) ? o : 0;
+        if (!bits) return false;
+        for (int i = 0; i < GEO.cellWindowCount[cell]; ++i) {
+            const uint64_t mask = GEO.windowMask[GEO.cellWindows[cell][i]];
+            if ((bits & mask) == mask) return true;
+        }
+        return false;
+    }
+    bool hasWon(char player) const { return completed[player == 'X' ? 0 : 1] > 0; }
+    int windowStones(char player, int window) const { return lineCount[player == 'X' ? 0 : 1][window]; }
+
+    uint64_t hash(int symmetry = 0) const { return hashes[symmetry]; }
+    int canonicalSymmetry() const {
+        int best = 0;
+        for (int s = 1; s < 8; ++s)
+            if (hashes[s] < hashes[best]) best = s;
+        return best;
+    }
+    uint64_t canonicalHash() const { return hashes[canonicalSymmetry()]; }
+
+private:
+    uint64_t x = 0;
+    uint64_t o = 0;
+    uint64_t hashes[8] = {};
+    int moves = 0;
+    uint8_t lineCount[2][Geometry::WINDOWS] = {};
+    int completed[2] = {};
+};
+
+template <int N, int K>
+struct FixedSize {
+    using BoardType = FixedBoard<N, K>;
+};
+
+// Calls f(FixedSize<N, K>{}) when size x size, K-in-a-row is one of the
+// boards with a compiled-in instantiation and returns true; false otherwise,
+// and the caller falls back to Board. Each entry costs a copy of the search.
+template <typename F>
+bool withFixedBoard(int size, int winLength, F&& f) {
+    switch (size * 16 + winLength) {
+    case 3 * 16 + 3: f(FixedSize<3, 3>{}); return true;
+    case 4 * 16 + 3: f(FixedSize<4, 3>{}); return true;
+    case 4 * 16 + 4: f(FixedSize<4, 4>{}); return true;
+    case 5 * 16 + 4: f(FixedSize<5, 4>{}); return true;
+    case 5 * 16 + 5: f(FixedSize<5, 5>{}); return true;
+    case 6 * 16 + 4: f(FixedSize<6, 4>{}); return true;
+    case 6 * 16 + 5: f(FixedSize<6, 5>{}); return true;
+    case 7 * 16 + 5: f(FixedSize<7, 5>{}); return true;
+    case 8 * 16 + 5: f(FixedSize<8, 5>{}); return true;
+    default: return false;
+    }
+}
+
+#endif // FIXEDBOARD_H
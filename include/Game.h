@@ -3,39 +3,99 @@
 
 #include <vector>
 #include <string>
+#include "Bitboard.h"
+#include "Board.h"
+#include "GameRecord.h"
+#include "GameTree.h"
+#include "MctsEngine.h"
+#include "SearchEngine.h"
+#include "TranspositionTable.h"
 
-struct TreeNode {
-    char board[3][3];
-    char player; // 'X' or 'O'
-    std::vector<TreeNode*> children;
-    int score;
-
-    TreeNode(char b[3][3], char p) {
-        for (int i = 0; i < 3; ++i)
-            for (int j = 0; j < 3; ++j)
-                board[i][j] = b[i][j];
-        player = p;
-        score = 0;
-    }
+// Which backend makeAIMoveWithTree uses. Table and Tree only exist for
+// 3x3; other sizes fall back to Search.
+enum class AIMode {
+    Table,  // compile-time solved positions
+    Tree,   // full game tree in an arena, reused across moves
+    Search, // iterative deepening alpha-beta
+    Mcts    // Monte Carlo tree search, any board size
 };
 
+class Telemetry;
+struct MoveStats;
+
 class Game {
 private:
-    std::vector<std::vector<char>> board;
+    Board board;
     char currentPlayer;
-    int minimax(int depth, bool isMaximizing);
+    uint8_t history[MAX_CELLS];      // cells in play order, board.moveCount() long
+    SearchEngine engine;             // alpha-beta search for any board size
+    SearchLimits limits;
+    MctsEngine mcts;
+    MctsLimits mctsLimits;
+    SearchEngine* lentEngine = nullptr; // used instead of engine/mcts while set
+    MctsEngine* lentMcts = nullptr;
+    AIMode aiMode = AIMode::Table;
+    GameTree tree;                   // arena for buildGameTree, rooted at the live board
+    TranspositionTable treeTT{12};   // used by minimaxTree
+    GameRecordWriter* recorder = nullptr;
+    uint32_t recordX = 0, recordO = 0; // player ids written with each record
+    Telemetry* telemetry = nullptr;
+    int minimax(int depth, bool isMaximizing); // depth-limited value, O maximizing
+    void makeTreeMove();
+    AIMode playAIMove(MoveStats* stats); // the backend that actually moved
+    void playCell(int cell);
+    SearchEngine& searchEngine() { return lentEngine ? *lentEngine : engine; }
+    const SearchEngine& searchEngine() const { return lentEngine ? *lentEngine : engine; }
+    MctsEngine& mctsEngine() { return lentMcts ? *lentMcts : mcts; }
 public:
-    Game();
+    Game(int size = 3, int winLength = 3);
+    void reset(); // new game on the same board size, keeps tables and arenas
     void displayBoard();
     bool makeMove(int row, int col);
+    bool undoMove(); // takes back the last move; its player becomes current again
     bool checkWin();
     bool checkDraw();
     void switchPlayer();
     char getCurrentPlayer();
+    int getSize() const { return board.size(); }
+    int getWinLength() const { return board.winLength(); }
+    const Board& getBoard() const { return board; }
+    int getLastMove() const { return board.moveCount() ? history[board.moveCount() - 1] : -1; }
+    void setSearchLimits(const SearchLimits& l) { limits = l; }
+    void setMctsLimits(const MctsLimits& l) { mctsLimits = l; }
+    const SearchLimits& getSearchLimits() const { return limits; }
+    const MctsLimits& getMctsLimits() const { return mctsLimits; }
+    void setAIMode(AIMode mode) { aiMode = mode; }
+    AIMode getAIMode() const { return aiMode; }
+    void setTelemetry(Telemetry* t) { telemetry = t; } // every AI move reports into it, nullptr to stop
+    Telemetry* getTelemetry() const { return telemetry; }
+    // Searches run on these engines instead of the game's own until unset with
+    // nullptr, so many games can share the tables of a few (e.g. one per
+    // thread). The game's own engines allocate nothing until they are used.
+    void lendEngines(SearchEngine* search, MctsEngine* mcts) {
+        lentEngine = search;
+        lentMcts = mcts;
+    }
+    // Every game that ends on this board is appended to the writer, which
+    // must outlive the game (or be unset with nullptr)
+    void setRecorder(GameRecordWriter* writer, uint32_t playerX = 0, uint32_t playerO = 0) {
+        recorder = writer;
+        recordX = playerX;
+        recordO = playerO;
+    }
+    // The tree lives in the game's arena: do not delete it, and the pointer
+    // is only valid until the next build
     TreeNode* buildGameTree(char b[3][3], char currentPlayer);
+    TreeNode* buildGameTree(const Bitboard& b, char currentPlayer);
 int evaluateBoard(char b[3][3]);
+int evaluateBoard(const Bitboard& b);
 int minimaxTree(TreeNode* node, bool isMaximizing);
 void makeAIMoveWithTree(); // Replaces previous AI logic
+AIMode measureAIMove(MoveStats& stats); // makeAIMoveWithTree, filling stats instead of reporting them
+int findBestMove(); // best cell for the current player via alpha-beta, -1 if none
+TTStats getSearchTTStats() const;
+TTStats getTreeTTStats() const;
+void clearTranspositionTables();
 
 };
 
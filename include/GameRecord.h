@@ -0,0 +1,147 @@
+#ifndef GAMERECORD_H
+#define GAMERECORD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Board.h"
+
+// Binary game records, many games per file. Layout, little endian:
+//
+//   file:   magic "TTGR" version:u32, then records back to back
+//   record: size:u8 winLength:u8 moves:u16 playerX:u32 playerO:u32 cells
+//
+// The low 14 bits of `moves` are the move count and the top 2 the result.
+// Cells are packed LSB first with just enough bits for the board (4 for
+// 3x3 and 4x4, 8 for 16x16), so a typical 3x3 game takes 16 bytes.
+
+enum class GameResult : uint8_t { Unfinished = 0, XWins = 1, OWins = 2, Draw = 3 };
+
+constexpr int RECORD_HEADER_BYTES = 12;
+
+constexpr int bitsPerMove(int size) {
+    int bits = 1;
+    while ((1 << bits) < size * size) ++bits;
+    return bits;
+}
+
+constexpr size_t recordBytes(int size, int moveCount) {
+    return RECORD_HEADER_BYTES + (size_t(moveCount) * bitsPerMove(size) + 7) / 8;
+}
+
+// Buffers whole records and appends them to the file; a crash can only
+// lose or tear the records still in the buffer. Safe to share between
+// threads, each write takes the lock for one record.
+class GameRecordWriter {
+public:
+    explicit GameRecordWriter(const std::string& path, size_t bufferBytes = 1 << 20);
+    ~GameRecordWriter();
+
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    bool isOpen() const { return file.is_open(); }
+    void write(int size, int winLength, uint32_t playerX, uint32_t playerO,
+               const uint8_t* cells, int moveCount, GameResult result);
+    void flush();
+    uint64_t records() const;
+
+private:
+    void flushLocked();
+
+    std::ofstream file;
+    std::vector<uint8_t> buffer;
+    size_t bufferLimit;
+    uint64_t written = 0;
+    mutable std::mutex lock;
+};
+
+// One record inside a mapped file. Only valid while the reader is open.
+class RecordView {
+public:
+    explicit RecordView(const uint8_t* data = nullptr) : data(data) {}
+
+    int size() const { return data[0]; }
+    int winLength() const { return data[1]; }
+    int moveCount() const { return moves() & 0x3FFF; }
+    GameResult result() const { return GameResult(moves() >> 14); }
+    uint32_t playerX() const { return u32(4); }
+    uint32_t playerO() const { return u32(8); }
+    int move(int i) const; // cell of the i-th move, X moves first
+    size_t bytes() const { return recordBytes(size(), moveCount()); }
+
+    // Plays the game onto a board of the right size; false if a move is illegal
+    bool replay(Board& board) const;
+
+private:
+    uint16_t moves() const { return uint16_t(data[2] | data[3] << 8); }
+    uint32_t u32(int at) const {
+        return uint32_t(data[at]) | uint32_t(data[at + 1]) << 8 |
+               uint32_t(data[at + 2]) << 16 | uint32_t(data[at + 3]) << 24;
+    }
+
+    const uint8_t* data;
+};
+
+// Maps a record file read-only and walks it in place, no copies:
+//
+//   GameRecordReader reader("games.ttgr");
+//   for (const RecordView& r : reader)
+//       if (r.result() == GameResult::Draw) ...
+//
+// Iteration stops at the first truncated or malformed record, so a file
+// torn by a crash still reads up to the damage.
+class GameRecordReader {
+public:
+    explicit GameRecordReader(const std::string& path);
+    ~GameRecordReader();
+
+    GameRecordReader(const GameRecordReader&) = delete;
+    GameRecordReader& operator=(const GameRecordReader&) = delete;
+
+    bool isOpen() const { return data != nullptr; }
+    const std::string& error() const { return failure; }
+    size_t fileBytes() const { return length; }
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = RecordView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const RecordView*;
+        using reference = const RecordView&;
+
+        iterator(const uint8_t* at, const uint8_t* end) : at(at), end(end), view(at) { check(); }
+        const RecordView& operator*() const { return view; }
+        const RecordView* operator->() const { return &view; }
+        iterator& operator++() {
+            at += view.bytes();
+            view = RecordView(at);
+            check();
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return at == other.at; }
+        bool operator!=(const iterator& other) const { return at != other.at; }
+
+    private:
+        void check(); // jumps to end unless a whole, sane record starts at `at`
+
+        const uint8_t* at;
+        const uint8_t* end;
+        RecordView view;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+
+private:
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+    std::string failure;
+};
+
+#endif // GAMERECORD_H
@@ -0,0 +1,81 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Game.h"
+#include "UserStore.h"
+
+struct ServerConfig {
+    int port = 0;               // TCP port on 127.0.0.1 when unixPath is empty, 0 = any
+    std::string unixPath;       // listen on a Unix socket instead
+    int workers = 0;            // AI threads, 0 = one per hardware thread
+    SearchLimits searchLimits;  // per AI move; each search stays single threaded
+    MctsLimits mctsLimits;
+    GameRecordWriter* recorder = nullptr; // finished games, players are 0 (human) and 1 + AIMode
+    Telemetry* telemetry = nullptr;       // AI move costs, served by STATS
+};
+
+// Many concurrent games over a line-based text protocol:
+//
+//   SIGNUP <user> <pass>          -> OK | ERR taken
+//   LOGIN <user> <pass>           -> OK | ERR auth
+//   NEW [size [win [table|search|mcts]]]
+//                                 -> OK <size> <win> (you are X, the AI is O)
+//   MOVE <row> <col>              -> AI <row> <col> [END X|O|DRAW] | END X|DRAW
+//   PING                          -> PONG
+//   STATS                         -> STATS <telemetry JSON> | ERR notelemetry
+//   QUIT                          -> BYE, then the server closes
+//
+// One thread runs a non-blocking epoll loop for all sockets. AI moves go to
+// a pool of worker threads and their results come back through an eventfd,
+// so the I/O thread never waits for a search.
+class GameServer {
+public:
+    GameServer(const ServerConfig& config, UserStore& users);
+    ~GameServer();
+
+    bool start(std::string& error); // bind and listen
+    void run();                     // serve until stop()
+    void stop();                    // safe from any thread
+    int port() const { return boundPort; }
+
+private:
+    struct Session;
+
+    void acceptAll();
+    void onReadable(const std::shared_ptr<Session>& s);
+    void onWritable(Session& s);
+    void handleLine(const std::shared_ptr<Session>& s, const std::string& line);
+    void send(Session& s, const std::string& text);
+    void close(Session& s);
+    void drainCompletions();
+    void workerLoop();
+
+    ServerConfig config;
+    UserStore& users;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    int boundPort = 0;
+    std::atomic<bool> running{false};
+    std::unordered_map<int, std::shared_ptr<Session>> sessions;
+
+    std::vector<std::thread> workers;
+    std::mutex jobLock;
+    std::condition_variable jobReady;
+    std::deque<std::shared_ptr<Session>> jobs;
+    bool stopping = false;
+
+    std::mutex doneLock;
+    std::vector<std::shared_ptr<Session>> done;
+};
+
+#endif // GAMESERVER_H
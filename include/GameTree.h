@@ -0,0 +1,46 @@
+#ifndef GAMETREE_H
+#define GAMETREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Bitboard.h"
+
+struct TreeNode {
+    Bitboard board;
+    char player;        // 'X' or 'O', the side to move
+    int8_t move;        // cell index that led here, -1 for a fresh root
+    uint8_t childCount;
+    int score;
+    int firstChild;     // arena index of the first child; siblings are contiguous
+};
+
+// Game tree stored in one contiguous arena. A node's children occupy the
+// index range [firstChild, firstChild + childCount), so there is no per-node
+// allocation and dropping the whole tree is O(1). Node pointers stay valid
+// until the next build().
+class GameTree {
+public:
+    TreeNode* build(const Bitboard& b, char player); // replaces any existing tree
+
+    TreeNode* root() { return rootIndex < 0 ? nullptr : &nodes[rootIndex]; }
+    TreeNode* child(const TreeNode& node, int i) { return &nodes[node.firstChild + i]; }
+
+    // Keep only the subtree reached by playing move from the root. Returns
+    // false (and drops the tree) if that subtree is not in the arena.
+    bool advance(int move);
+
+    bool rewind();  // back to the position the tree was built from, if any
+    void reset();   // O(1), keeps the arena's memory for the next build
+    void release(); // also hands the memory back
+
+    size_t size() const { return nodes.size(); }
+
+private:
+    void expand(int index);
+
+    std::vector<TreeNode> nodes;
+    int rootIndex = -1;
+};
+
+#endif // GAMETREE_H
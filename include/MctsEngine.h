@@ -0,0 +1,69 @@
+#ifndef MCTSENGINE_H
+#define MCTSENGINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Board.h"
+
+struct MctsLimits {
+    int playouts = 50000;      // total across threads, 0 = no limit
+    int timeBudgetMs = 500;    // hard budget per move, 0 = no limit
+    int threads = 1;
+    double exploration = 1.4;  // UCT constant
+    uint64_t seed = 0x4D435453;
+    const std::atomic<bool>* stop = nullptr; // set it to end the search early
+};
+
+struct MctsResult {
+    int move = -1;             // most visited root child, -1 if no legal move
+    uint64_t playouts = 0;
+    double winRate = 0;        // of the chosen move, draws count half
+    size_t nodesUsed = 0;
+    int treeDepth = 0;         // deepest tree node a playout started from
+    double elapsedMs = 0;
+};
+
+// UCT Monte Carlo tree search over any Board. Nodes come from a fixed-size
+// pool allocated on the first search; when it runs out the tree simply stops
+// growing and playouts continue from the leaves. With threads > 1 all threads
+// share one tree (tree parallelism), using a virtual loss on the way down so
+// they spread over different branches.
+class MctsEngine {
+public:
+    explicit MctsEngine(size_t poolSize = size_t(1) << 20);
+
+    MctsResult search(const Board& board, char player, const MctsLimits& limits);
+
+private:
+    struct Node {
+        std::atomic<int> visits;
+        std::atomic<int> reward;      // half-points for the side that moved into this node
+        std::atomic<int> firstChild;
+        std::atomic<uint8_t> state;   // 0 leaf, 1 being expanded, 2 expanded
+        int parent;
+        int16_t move;
+        uint16_t childCount;
+        char mover;                   // side that played move
+        char winner;                  // 'X'/'O' if move ended the game, 'D' draw, 0 otherwise
+    };
+
+    int newNodes(int count);
+    void initNode(int index, int parent, int move, char mover, char winner);
+    int selectChild(const Node& node, double exploration) const;
+    void expand(int index, Board& board, char toMove);
+    char playout(Board& board, char toMove, uint64_t& rng) const;
+    void runThread(const Board& root, char player, const MctsLimits& limits, uint64_t seed);
+
+    size_t capacity;
+    std::unique_ptr<Node[]> pool;
+    std::atomic<int> used{0};
+    std::atomic<int> playoutsLeft{0};
+    std::atomic<uint64_t> playoutsDone{0};
+    std::atomic<int> deepest{0};
+    std::chrono::steady_clock::time_point deadline;
+};
+
+#endif // MCTSENGINE_H
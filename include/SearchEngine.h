@@ -0,0 +1,92 @@
+#ifndef SEARCHENGINE_H
+#define SEARCHENGINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+#include "TranspositionTable.h"
+
+class Tablebase;
+
+// Scores are from the side to move. A win found at ply p scores WIN_SCORE - p,
+// so shorter wins rank higher; heuristic scores stay below HEURISTIC_LIMIT.
+constexpr int WIN_SCORE = 30000;
+constexpr int HEURISTIC_LIMIT = 20000;
+
+struct SearchLimits {
+    int maxDepth = 64;      // plies
+    int timeBudgetMs = 500; // hard budget per move, 0 = no limit
+    int threads = 1;        // root moves are split across this many threads
+    const Tablebase* tablebase = nullptr; // exact values where it covers the board
+    const std::atomic<bool>* stop = nullptr; // set it to end the search early, like the budget running out
+};
+
+struct SearchResult {
+    int move = -1;          // cell index, -1 if there is no legal move
+    int score = 0;
+    int depth = 0;          // last fully completed iteration
+    uint64_t nodes = 0;
+    double elapsedMs = 0;
+};
+
+// Alpha-beta (negamax) search over any N x N, K-in-a-row board with a
+// transposition table, TT/history move ordering, and iterative deepening
+// under a hard time budget. The best move of the last completed iteration is
+// always returned, so a move comes back within the budget. Positions a
+// tablebase covers are scored from it instead of being searched.
+//
+// With threads > 1 each iteration searches the first root move, then hands
+// the remaining root moves to helper engines that share this engine's table
+// and the best score so far. Every root move that can tie the best is
+// searched with a window that keeps its score exact, and once all scores are
+// in the move is the lowest-index one with the best score, as in the serial
+// loop. Entries one helper stores can cut off another's search, so node
+// counts vary between parallel runs; threads = 1 is the plain serial search.
+class SearchEngine {
+public:
+    explicit SearchEngine(int ttSizeLog2 = 18);
+
+    SearchResult search(Board& board, char player, const SearchLimits& limits);
+
+    // Fixed-depth alpha-beta value of the position for player, no time limit
+    int alphaBeta(Board& board, char player, int depth);
+
+    TTStats ttStats() const;
+    void clear();
+
+private:
+    // The search is written once over a board type B: Board for any size, or
+    // a FixedBoard for the sizes withFixedBoard() lists, which search() and
+    // alphaBeta() switch to so the hot loops run on compile-time tables.
+    void begin(const SearchLimits& limits, std::chrono::steady_clock::time_point start);
+    template <typename B>
+    void deepen(B& board, char player, const SearchLimits& limits, SearchResult& result);
+    template <typename B>
+    int searchRootMove(B& board, char player, int cell, int depth, int alpha);
+    template <typename B>
+    bool searchParallel(B& board, char player, const int* moves, int count,
+                        int depth, int threads, int& best, int& bestIndex);
+    template <typename B>
+    int negamax(B& board, char player, int depth, int alpha, int beta, int ply);
+    template <typename B>
+    int evaluate(const B& board, char player) const;
+    template <typename B>
+    int generateMoves(const B& board, int ttMove, char player, int* moves) const;
+    bool outOfTime();
+
+    TranspositionTable tt;
+    TranspositionTable* sharedTT = nullptr; // a helper searches its owner's table
+    TTCounters ttCounters;
+    std::vector<SearchEngine> helpers;
+    int history[2][MAX_CELLS];
+    uint64_t nodes = 0;
+    bool stopped = false;
+    bool timed = false;
+    const Tablebase* tablebase = nullptr;
+    const std::atomic<bool>* stopFlag = nullptr;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+#endif // SEARCHENGINE_H
@@ -0,0 +1,49 @@
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <cstdint>
+#include "Game.h"
+
+// One side of a self-play match: a uniformly random mover or an AI backend
+struct PlayerSpec {
+    bool random = false;
+    AIMode mode = AIMode::Table;
+};
+
+// Accepts random, table, tree, search or mcts
+bool parsePlayer(const char* name, PlayerSpec& out);
+const char* playerName(const PlayerSpec& p);
+
+struct SelfPlayConfig {
+    int size = 3;
+    int winLength = 3;
+    uint64_t games = 100000;
+    int threads = 0;            // 0 = one per hardware thread
+    PlayerSpec x{true, AIMode::Table};
+    PlayerSpec o{false, AIMode::Table};
+    SearchLimits searchLimits;  // per engine, searches stay single threaded
+    MctsLimits mctsLimits;
+    uint64_t seed = 1;
+    GameRecordWriter* recorder = nullptr; // optional; player ids are 0 random, 1 + AIMode
+    Telemetry* telemetry = nullptr;       // optional, shared by all threads
+};
+
+struct SelfPlayStats {
+    uint64_t games = 0;
+    uint64_t xWins = 0;
+    uint64_t oWins = 0;
+    uint64_t draws = 0;
+    uint64_t moves = 0;
+    double seconds = 0;
+
+    double gamesPerSec() const { return seconds > 0 ? games / seconds : 0; }
+    double movesPerSec() const { return seconds > 0 ? moves / seconds : 0; }
+};
+
+// Plays config.games headless games spread over worker threads. Each thread
+// owns one Game (reset between games) and its own RNG, and only touches
+// shared state to claim the next batch of games and to add its totals at
+// the end, so there is no I/O or locking on the hot path.
+SelfPlayStats runSelfPlay(const SelfPlayConfig& config);
+
+#endif // SELFPLAY_H
@@ -0,0 +1,76 @@
+#ifndef SOLVEDTABLE_H
+#define SOLVEDTABLE_H
+
+#include <cstdint>
+#include "Bitboard.h"
+
+// Every 3x3 board solved at compile time. A board is encoded in base 3,
+// cell i contributing 3^i (X) or 2 * 3^i (O), so there are 3^9 encodings.
+constexpr int BOARD_ENCODINGS = 19683;
+
+struct SolvedEntry {
+    int8_t move;  // best cell for the side to move, -1 if the game is over
+    int8_t value; // minimax value: +1 O wins, -1 X wins, 0 draw
+};
+
+struct SolvedTable {
+    uint16_t base3[512];                        // bitmask -> base-3 digits of 1
+    SolvedEntry entries[2][BOARD_ENCODINGS];    // [0] X to move, [1] O to move
+};
+
+constexpr SolvedTable buildSolvedTable() {
+    SolvedTable t{};
+    int pow3[9] = {};
+    for (int i = 0, p = 1; i < 9; ++i, p *= 3) pow3[i] = p;
+
+    for (int mask = 0; mask < 512; ++mask) {
+        int code = 0;
+        for (int i = 0; i < 9; ++i)
+            if (mask & (1 << i)) code += pow3[i];
+        t.base3[mask] = static_cast<uint16_t>(code);
+    }
+
+    // Placing a piece only ever increases the encoding, so walking the
+    // encodings downwards solves every child before its parent.
+    for (int code = BOARD_ENCODINGS - 1; code >= 0; --code) {
+        Bitboard b;
+        for (int i = 0, rest = code; i < 9; ++i, rest /= 3) {
+            if (rest % 3 == 1) b.x |= 1u << i;
+            else if (rest % 3 == 2) b.o |= 1u << i;
+        }
+
+        int score = evaluateBits(b);
+        uint16_t empty = ~occupied(b) & FULL_BOARD;
+        for (int side = 0; side < 2; ++side) {
+            SolvedEntry& e = t.entries[side][code];
+            e.move = -1;
+            e.value = static_cast<int8_t>(score);
+            if (score != 0 || empty == 0) continue;
+
+            // O maximizes, X minimizes; ties keep the first cell, like minimaxTree
+            int best = side ? -1000 : 1000;
+            for (int i = 0; i < 9; ++i) {
+                if (!(empty & (1u << i))) continue;
+                int v = t.entries[1 - side][code + pow3[i] * (side + 1)].value;
+                if (side ? v > best : v < best) {
+                    best = v;
+                    e.move = static_cast<int8_t>(i);
+                }
+            }
+            e.value = static_cast<int8_t>(best);
+        }
+    }
+    return t;
+}
+
+inline constexpr SolvedTable SOLVED_TABLE = buildSolvedTable();
+
+inline int encodeBoard(const Bitboard& b) {
+    return SOLVED_TABLE.base3[b.x] + 2 * SOLVED_TABLE.base3[b.o];
+}
+
+inline const SolvedEntry& solvedEntry(const Bitboard& b, char toMove) {
+    return SOLVED_TABLE.entries[toMove == 'O'][encodeBoard(b)];
+}
+
+#endif // SOLVEDTABLE_H
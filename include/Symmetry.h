@@ -0,0 +1,55 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <cstdint>
+#include "Bitboard.h"
+#include "SolvedTable.h"
+
+// The 8 rotations and reflections of the 3x3 board, as lookup tables from
+// a 9-bit mask to its transformed mask.
+struct SymmetryTable {
+    uint16_t map[8][512];
+};
+
+constexpr SymmetryTable buildSymmetryTable() {
+    SymmetryTable t{};
+    for (int s = 0; s < 8; ++s) {
+        int perm[9] = {};
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c) {
+                int rr = r, cc = c;
+                for (int k = 0; k < (s & 3); ++k) { // rotate 90 degrees s&3 times
+                    int tmp = rr;
+                    rr = cc;
+                    cc = 2 - tmp;
+                }
+                if (s & 4) cc = 2 - cc; // then mirror
+                perm[cellIndex(r, c)] = cellIndex(rr, cc);
+            }
+        for (int mask = 0; mask < 512; ++mask) {
+            int out = 0;
+            for (int i = 0; i < 9; ++i)
+                if (mask & (1 << i)) out |= 1 << perm[i];
+            t.map[s][mask] = static_cast<uint16_t>(out);
+        }
+    }
+    return t;
+}
+
+inline constexpr SymmetryTable SYMMETRY_TABLE = buildSymmetryTable();
+
+inline Bitboard transformBoard(const Bitboard& b, int sym) {
+    return Bitboard(SYMMETRY_TABLE.map[sym][b.x], SYMMETRY_TABLE.map[sym][b.o]);
+}
+
+// Smallest base-3 encoding over all 8 symmetries of the board
+inline int canonicalEncoding(const Bitboard& b) {
+    int best = encodeBoard(b);
+    for (int s = 1; s < 8; ++s) {
+        int code = encodeBoard(transformBoard(b, s));
+        if (code < best) best = code;
+    }
+    return best;
+}
+
+#endif // SYMMETRY_H
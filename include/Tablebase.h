@@ -0,0 +1,86 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Board.h"
+
+// Endgame tablebases for boards up to 5x5, built offline by retrograde
+// analysis and mapped read-only at startup.
+//
+// Positions are grouped into levels by stone count k. Within a level X has
+// ceil(k/2) stones, so the side to move follows from k, and a position is
+// indexed combinatorially: the colex rank of the occupied set times C(k, x)
+// plus the colex rank of which occupied cells hold X. Level k therefore
+// takes C(n, k) * C(k, ceil(k/2)) bytes, about 10M for all of 4x4.
+//
+// One byte per position, for the side to move:
+//   bits 0-1  0 = unreachable (the side to move has a line), 1 = loss,
+//             2 = draw, 3 = win
+//   bits 2-7  plies until the game ends, the winner playing for the
+//             quickest end and the loser for the longest
+//
+// File layout, little endian:
+//   magic "TTTB" version:u32 size:u8 winLength:u8 minPieces:u8 pad:u8 pad:u32
+//   offset:u64 for each level 0..25 (0 when the level is not stored), data
+constexpr int TABLEBASE_MAX_SIZE = 5;
+constexpr int TABLEBASE_MAX_CELLS = TABLEBASE_MAX_SIZE * TABLEBASE_MAX_SIZE;
+
+class Tablebase {
+public:
+    Tablebase() = default;
+    ~Tablebase();
+
+    Tablebase(const Tablebase&) = delete;
+    Tablebase& operator=(const Tablebase&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+    bool isOpen() const { return data != nullptr; }
+    int size() const { return boardSize; }
+    int winLength() const { return win; }
+    int minPieces() const { return lowest; }
+
+    // Value for the side to move (+1 win, 0 draw, -1 loss) and plies to the
+    // end; false if the board is not covered
+    bool probe(const Board& board, int& value, int& distance) const;
+    bool probe(int size, int winLength, uint64_t x, uint64_t o, int& value, int& distance) const;
+
+    // Best cell for the side to move, -1 if not covered or the game is over.
+    // Ties go to the lowest cell.
+    int bestMove(const Board& board, int& value, int& distance) const;
+
+private:
+    bool probeBits(uint32_t x, uint32_t o, int& value, int& distance) const;
+
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+    int boardSize = 0;
+    int win = 0;
+    int lowest = 0;
+    uint64_t levelOffset[TABLEBASE_MAX_CELLS + 1] = {};
+};
+
+struct SolveConfig {
+    int size = 4;
+    int winLength = 4;
+    int minPieces = -1;     // lowest level solved, -1 = all of them up to 4x4, n - 1 on 5x5
+    int threads = 0;        // 0 = one per hardware thread
+    std::string path;
+};
+
+struct SolveStats {
+    uint64_t positions = 0; // entries written, including non-positions
+    uint64_t wins = 0;
+    uint64_t draws = 0;
+    uint64_t losses = 0;
+    uint64_t bytes = 0;     // file size
+    double seconds = 0;
+};
+
+// Solves levels from the full board down to minPieces. Every position of
+// level k only depends on level k + 1, so each level is split into chunks
+// of occupied sets that worker threads claim from a shared counter.
+bool solveTablebase(const SolveConfig& config, SolveStats& stats, std::string& error);
+
+#endif // TABLEBASE_H
@@ -0,0 +1,92 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "Game.h"
+
+// Log-linear latency histogram in the HDR style: values below 32 ns get
+// their own bucket, above that every power of two is split into 32
+// buckets, so any percentile is within about 3% of the true value. All
+// counters are relaxed atomics; record() is a handful of adds and is safe
+// from any thread.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t nanos);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t min() const;
+    uint64_t max() const { return largest.load(std::memory_order_relaxed); }
+    double mean() const;
+    uint64_t percentile(double p) const; // upper edge of the bucket holding it, in ns
+
+private:
+    static int bucketOf(uint64_t nanos);
+    static uint64_t upperEdge(int bucket);
+
+    std::atomic<uint64_t> buckets[BUCKETS];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> smallest;
+    std::atomic<uint64_t> largest;
+};
+
+// What one AI move cost
+struct MoveStats {
+    uint64_t nanos = 0;
+    uint64_t nodes = 0;       // positions visited (playouts for MCTS, 1 for a table read)
+    uint64_t treeNodes = 0;   // nodes held in a tree or arena after the move
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    uint64_t allocations = 0; // made by the moving thread, not search helpers
+    int depth = 0;            // completed search depth, or tree depth for MCTS
+    bool pondered = false;    // searched by AsyncAI before the move was asked for
+};
+
+// Aggregates MoveStats per backend. A Game reports into it after every AI
+// move once setTelemetry() is called; a Game without one pays a single
+// branch. One instance can be shared by any number of games and threads.
+class Telemetry {
+public:
+    void recordMove(AIMode backend, const MoveStats& move);
+    // A search run ahead of time by AsyncAI, whether or not its answer is
+    // played. A played answer is also reported through recordMove, marked
+    // pondered and with the search's cost, not the time the caller waited.
+    void recordPonder(AIMode backend, const MoveStats& search);
+    void reset();
+
+    // {"uptime_s":..,"backends":{"search":{"moves":..,"nodes_per_sec":..,
+    // "latency_ns":{"p50":..,"p99":..},...}}} on one line, only for
+    // backends that have played or pondered
+    std::string toJson() const;
+
+    const LatencyHistogram& latency(AIMode backend) const { return stats[int(backend)].latency; }
+
+private:
+    struct Backend {
+        std::atomic<uint64_t> moves{0};
+        std::atomic<uint64_t> nanos{0};
+        std::atomic<uint64_t> nodes{0};
+        std::atomic<uint64_t> ttProbes{0};
+        std::atomic<uint64_t> ttHits{0};
+        std::atomic<uint64_t> allocations{0};
+        std::atomic<uint64_t> depthSum{0};
+        std::atomic<uint64_t> peakTreeNodes{0};
+        std::atomic<uint64_t> ponderedMoves{0};
+        std::atomic<uint64_t> ponderSearches{0};
+        std::atomic<uint64_t> ponderNodes{0};
+        LatencyHistogram latency;
+    };
+
+    Backend stats[4];
+    std::atomic<int64_t> started{0}; // steady clock ns of the first move since reset
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,98 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum TTFlag : uint8_t {
+    TT_EXACT,
+    TT_LOWER, // score is a lower bound (search failed high)
+    TT_UPPER  // score is an upper bound (search failed low)
+};
+
+struct TTEntry {
+    uint64_t key;
+    int16_t score;
+    int8_t depth;    // remaining depth the score is valid for, -1 = empty slot
+    uint8_t flag;
+    int16_t bestMove;
+};
+
+// Probe and store counts of one thread. Threads sharing a table keep their
+// own, so counting never contends; stats() adds them up.
+struct TTCounters {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t overwrites = 0;
+    size_t used = 0; // stores into an empty slot
+
+    TTCounters& operator+=(const TTCounters& o) {
+        probes += o.probes;
+        hits += o.hits;
+        stores += o.stores;
+        overwrites += o.overwrites;
+        used += o.used;
+        return *this;
+    }
+};
+
+struct TTStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+    uint64_t overwrites; // stores that evicted a different position
+    size_t used;
+    size_t capacity;
+
+    double hitRate() const { return probes ? double(hits) / probes : 0.0; }
+};
+
+// Fixed-size, always-replace hash table of search results. Keys are any
+// 64-bit position key (a base-3 index on 3x3, a Zobrist hash on larger
+// boards); callers are expected to hand in a symmetry-canonical key so that
+// rotated and reflected boards share one entry. Memory is allocated on the
+// first store, so an unused table costs nothing.
+//
+// Several threads may probe and store at once. Each slot is two words, the
+// packed entry and the key XORed with it, written and read without locks; a
+// slot torn by a concurrent store fails the key check and reads as a miss.
+// Call reserve() before sharing so the first store does not race to
+// allocate. The overloads taking TTCounters count into the caller's own.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(int sizeLog2 = 16);
+    TranspositionTable(TranspositionTable&&) = default;
+    TranspositionTable& operator=(TranspositionTable&&) = default;
+
+    bool probe(uint64_t key, TTEntry& out) { return probe(key, out, counters); }
+    void store(uint64_t key, int score, int depth, TTFlag flag, int bestMove = -1) {
+        store(key, score, depth, flag, bestMove, counters);
+    }
+    bool probe(uint64_t key, TTEntry& out, TTCounters& count) const;
+    void store(uint64_t key, int score, int depth, TTFlag flag, int bestMove, TTCounters& count);
+    void reserve();
+    void clear();
+    void resize(int sizeLog2);
+
+    TTStats stats() const { return stats(counters); }
+    TTStats stats(const TTCounters& count) const;
+    size_t capacity() const { return size_t(1) << log2Size; }
+    int sizeLog2() const { return log2Size; }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> check{0}; // key ^ data
+        std::atomic<uint64_t> data{0};  // packed entry, depth byte 0 = empty
+    };
+
+    size_t slot(uint64_t key) const;
+
+    std::unique_ptr<Slot[]> table;
+    int log2Size;
+    TTCounters counters;
+};
+
+#endif // TRANSPOSITIONTABLE_H
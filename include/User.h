@@ -3,11 +3,17 @@
 
 #include <string>
 #include <unordered_map>
+#include "UserStore.h"
 
 class User {
 public:
+    User();                 // uses the shared store over users.txt
+    explicit User(UserStore& store);
     bool signup(const std::string& username, const std::string& password);
     bool login(const std::string& username, const std::string& password);
+
+private:
+    UserStore& store;
 };
 
 #endif
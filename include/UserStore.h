@@ -0,0 +1,62 @@
+#ifndef USERSTORE_H
+#define USERSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Accounts held in a hash index, loaded once per process.
+//
+// New accounts are appended to the log (users.txt, one "name password" line
+// each, the format the game has always used), flushed every flushEvery
+// signups and on shutdown. The log is never rewritten and stays the record
+// of every account. Compaction writes the whole index to a snapshot file
+// along with the log size it covers, so a restart reads the snapshot in one
+// go and replays only the signups since; losing the snapshot only costs a
+// full replay. Compaction runs once the log holds compactEvery signups past
+// the snapshot and a quarter of the index.
+class UserStore {
+public:
+    explicit UserStore(const std::string& logPath = "users.txt",
+                       const std::string& snapshotPath = "users.snapshot");
+    ~UserStore();
+
+    UserStore(const UserStore&) = delete;
+    UserStore& operator=(const UserStore&) = delete;
+
+    bool contains(const std::string& username) const;
+    bool check(const std::string& username, const std::string& password) const;
+    bool add(const std::string& username, const std::string& password); // false if taken or invalid
+
+    void flush();   // push buffered log lines to the file
+    void compact(); // snapshot the index so a restart skips the log so far
+    size_t size() const;
+
+    void setFlushEvery(int n) { flushEvery = n > 0 ? n : 1; }
+    void setCompactEvery(int n) { compactEvery = n; }
+
+    static UserStore& instance(); // shared store over users.txt in the working directory
+
+private:
+    void load();
+    bool loadSnapshot(uint64_t& logOffset);
+    void replayLog(uint64_t fromOffset);
+    bool writeSnapshot();
+    void compactLocked();
+
+    std::string logPath;
+    std::string snapshotPath;
+    std::unordered_map<std::string, std::string> users;
+    std::ofstream log;
+    uint64_t logSize = 0;          // bytes in the log, including buffered lines
+    int pendingFlush = 0;
+    int appendsSinceSnapshot = 0;  // log lines past the snapshot's offset
+    int flushEvery = 64;
+    int compactEvery = 10000;
+    mutable std::mutex lock;
+};
+
+#endif // USERSTORE_H
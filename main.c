@@ -9,67 +9,88 @@
 #include "task.h"
 #include "queue.h"
 #include "semphr.h"
+#include "netsim/netsim.h"  // Packet format, pools, delay line and per-packet decisions, shared with the Linux host
+#include "netsim/trace.h"   // Binary per-packet trace, decoded by TraceTask; build with -DTRACE_LEVEL=N to filter
 
-// Constants used for the packet structure and simulation settings
-#define PACKET_SIZE 1000            // Packet size set to 1000 bytes as requirements 
-#define SENDER_PERIOD_MS 200        // Sender generates packets every 200 milliseconds
-#define SWITCH_DELAY_MS 200         // Switch delays forwarding by 200 milliseconds
-#define DROP_PROBABILITY 0.01       // 1% probability for packet drop
-#define NUM_SENDERS 2               // Number of sender tasks is 2
-#define NUM_RECEIVERS 2             // Number of receiver tasks is 2
-#define PACKETS_PER_RECEIVER 200    // Default number of packets for each receiver to stop at; can be changed
-
-// Packet structure definition, total size is 1000 bytes
-typedef struct {
-    uint32_t seq_num;               // Sequence number for tracking packets
-    uint16_t length;                // Length of the packet (1000 bytes)
-    uint8_t dest;                   // Destination ID (3 or 4, displayed as 1 or 2 in logs)
-    uint8_t sender_id;              // Sender ID (0 or 1, displayed as 1 or 2 in logs)
-    uint8_t data[PACKET_SIZE - sizeof(uint32_t) - sizeof(uint16_t) - 2 * sizeof(uint8_t)]; // Remaining bytes for data payload
-} Packet_t;
+// The switch blocks on all sender queues at once through a queue set
+#if !defined(configUSE_QUEUE_SETS) || configUSE_QUEUE_SETS != 1
+#error "main.c needs configUSE_QUEUE_SETS 1 in FreeRTOSConfig.h"
+#endif
 
 // Global variables for managing queues, counters, and task handles
-QueueHandle_t sender_queues[NUM_SENDERS];        // Queues for sender-to-switch communication
-QueueHandle_t receiver_queues[NUM_RECEIVERS];    // Queues for switch-to-receiver communication
-uint32_t receiver_counts[NUM_RECEIVERS];         // Tracks the number of packets received by each receiver
-uint32_t receiver_lost[NUM_RECEIVERS];           // Tracks the number of lost packets for each receiver
-uint32_t last_seq[NUM_RECEIVERS][NUM_SENDERS];   // Stores the last sequence number for each sender-receiver pair
+uint16_t num_senders = NUM_SENDERS;              // Sender-facing switch ports; change before the run for a bigger switch
+uint16_t num_receivers = NUM_RECEIVERS;          // Receiver-facing switch ports
+QueueHandle_t *sender_queues;                    // Queues for sender-to-switch communication, one per sender
+QueueHandle_t *receiver_queues;                  // Queues for switch-to-receiver communication, one per receiver
+QueueSetHandle_t switch_input_set;               // All sender queues; the switch blocks on it (configUSE_QUEUE_SETS 1)
+Switch_t net_switch;                             // Forwarding table and per-port counters
+ReceiverStats_t *receiver_stats;                 // Packets received and lost, last sequence number per sender
 SemaphoreHandle_t simulation_done_sem;           // Semaphore to signal when the simulation is complete
-TaskHandle_t sender_handles[NUM_SENDERS];        // Handles for sender tasks
+TaskHandle_t *sender_handles;                    // Handles for sender tasks
 TaskHandle_t switch_handle;                      // Handle for the switch task
-TaskHandle_t receiver_handles[NUM_RECEIVERS];    // Handles for receiver tasks
+TaskHandle_t *receiver_handles;                  // Handles for receiver tasks
 TaskHandle_t terminator_handle;                  // Handle for the terminator task
+TaskHandle_t trace_handle;                       // Handle for the trace decoder task
+TraceRing_t *trace_rings;                        // One per task: senders, then the switch, then receivers
 uint32_t packets_to_stop = PACKETS_PER_RECEIVER; // Number of packets to stop at; set to 200 for this phase but can be changed
+uint32_t run_seed;                               // Seed of every task's random stream
+uint32_t delay_line_length;                      // Packets the switch can delay at once, 8 per port
+
+PacketPools_t pools;                             // Packet and payload storage with their free lists, set up in main
+
+// Allocates zeroed storage for count items at startup; NULL if the heap is too small
+void *alloc_table(size_t count, size_t size) {
+    void *p = pvPortMalloc(count * size);
+    if (p) {
+        memset(p, 0, count * size);
+    }
+    return p;
+}
+
+// Like alloc_table, but the first item starts on an align-byte boundary (a power of two).
+// pvPortMalloc only guarantees portBYTE_ALIGNMENT, so this takes align - 1 bytes extra and
+// rounds up; like every table here it is never freed.
+void *alloc_aligned_table(size_t count, size_t size, size_t align) {
+    uint8_t *p = alloc_table(1, count * size + align - 1);
+    if (!p) {
+        return NULL;
+    }
+    return p + (-(uintptr_t)p & (align - 1));
+}
 
 // Sender task: generates packets every 200ms and sends them to the sender’s queue
 void SenderTask(void *pvParameters) {
-    int sender_id = (int)pvParameters;          // Sender ID (0 or 1)
-    uint32_t seq_nums[NUM_RECEIVERS] = {0};     // Sequence numbers for each destination
+    int sender_id = (int)pvParameters;          // Sender ID (0 to num_senders - 1)
+    uint32_t *seq_nums = alloc_table(num_receivers, sizeof(uint32_t)); // Sequence numbers for each destination
     TickType_t last_wake = xTaskGetTickCount(); // Used to maintain precise 200ms timing
+    SimRandom_t rng;                            // This sender's random stream
+    TraceRing_t *trace = &trace_rings[sender_id]; // This sender's trace events
+    sim_seed(&rng, run_seed, STREAM_SENDER(sender_id));
+    if (!seq_nums) {
+        printf("Sender %d: Failed to allocate sequence numbers\n", sender_id + 1);
+        vTaskSuspend(NULL);
+    }
 
     while (1) {
-        // Allocate memory for a new packet
-        Packet_t *packet = (Packet_t *)pvPortMalloc(sizeof(Packet_t));
+        // Take a packet from the pool; if it is empty, skip this period
+        Packet_t *packet = packet_alloc(&pools, SENDER_ATTACH_PAYLOAD);
         if (!packet) {
-            printf("Sender %d: Malloc failed\n", sender_id + 1);
+            TRACE(trace, xTaskGetTickCount(), TRACE_POOL_EMPTY, sender_id, 0, 0, 0);
+            vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SENDER_PERIOD_MS));
             continue;
         }
 
-        // Set packet details: random destination (3 or 4), sequence number, length, and sender ID
-        packet->dest = (rand() % 2) + 3;
-        packet->seq_num = seq_nums[packet->dest - 3]++;
-        packet->length = PACKET_SIZE;
-        packet->sender_id = sender_id;
-        memset(packet->data, 0, sizeof(packet->data)); // Clear the data payload to avoid random values
+        // Set packet details: random destination, sequence number, length, and sender ID
+        sender_make_packet(packet, sender_id, seq_nums, num_receivers, &rng);
+        // The payload block is left as is: it was zeroed at startup and nobody writes it
 
-        // Print packet generation details (Sender 1/2, Receiver 1/2)
-        printf("Sender %d: Generated packet for dest %d, seq %u\n",
-               sender_id + 1, packet->dest - 2, packet->seq_num);
+        // Record packet generation details (Sender 1/2, Receiver 1/2)
+        TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_GENERATED, packet, 0);
 
         // Send the packet to the sender’s queue; free memory if the queue is full
         if (xQueueSend(sender_queues[sender_id], &packet, portMAX_DELAY) != pdTRUE) {
-            printf("Sender %d: Queue send failed\n", sender_id + 1);
-            vPortFree(packet);
+            TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_SEND_FAILED, packet, 0);
+            packet_free(&pools, packet);
         }
 
         // Wait 200ms to maintain the packet generation rate
@@ -77,104 +98,175 @@ void SenderTask(void *pvParameters) {
     }
 }
 
-// Switch task: processes packets from sender queues, applies drop probability, and forwards to receivers
+// Sends a packet whose delay has elapsed to the output port its destination routes to
+void switch_forward(Packet_t *packet, TraceRing_t *trace) {
+    uint16_t port = switch_route(&net_switch, packet);
+    if (port == PORT_NONE) {
+        // Handle invalid destination by logging, counting it on the input port and freeing the packet
+        TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_INVALID_DEST, packet, 0);
+        net_switch.stats[packet->sender_id].invalid++;
+        packet_free(&pools, packet);
+        return;
+    }
+    TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_FORWARDED, packet, 0);
+    // The output queue does not block the other ports: when it is full the packet is lost
+    QueueHandle_t out = receiver_queues[port - net_switch.senders];
+    if (xQueueSend(out, &packet, 0) != pdTRUE) {
+        TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_OVERFLOW, packet, 0);
+        net_switch.stats[port].overflow++;
+        packet_free(&pools, packet);
+        return;
+    }
+    port_count_tx(&net_switch.stats[port], packet, uxQueueMessagesWaiting(out));
+}
+
+// Switch task: takes packets from the sender queues, applies the drop probability, and holds each
+// surviving packet in a time-ordered delay line for 200ms before forwarding it. Many packets can be
+// in the delay at once, and the task blocks on the queue set until either a packet arrives or the
+// earliest delayed packet is due, so it uses no CPU while idle.
 void SwitchTask(void *pvParameters) {
-    Packet_t *packet; // Pointer to the received packet
+    DelayedPacket_t *delayed = pvParameters; // Delay line storage, delay_line_length entries
+    DelayLine_t delay_line;         // Packets waiting out the switch delay
+    Packet_t *packet;               // Pointer to the received packet
+    SimRandom_t rng;                // The switch's random stream
+    TraceRing_t *trace = &trace_rings[num_senders]; // The switch's trace events
+    delay_line_init(&delay_line, delayed, delay_line_length);
+    sim_seed(&rng, run_seed, STREAM_SWITCH);
 
     while (1) {
-        // Check each sender queue for incoming packets
-        for (int i = 0; i < NUM_SENDERS; i++) {
-            if (xQueueReceive(sender_queues[i], &packet, 0) == pdTRUE) {
-                // Apply a 1% probability to drop the packet
-                if ((double)rand() / RAND_MAX < DROP_PROBABILITY) {
-                    printf("Switch: Dropped packet from sender %d for dest %d, seq %u\n",
-                           packet->sender_id + 1, packet->dest - 2, packet->seq_num);
-                    vPortFree(packet); // Free the dropped packet
-                } else {
-                    // Simulate a 200ms forwarding delay
-                    vTaskDelay(pdMS_TO_TICKS(SWITCH_DELAY_MS));
-                    // Forward the packet to the correct receiver (dest 3 or 4)
-                    if (packet->dest >= 3 && packet->dest <= 4) {
-                        printf("Switch: Forwarding packet from sender %d to dest %d, seq %u\n",
-                               packet->sender_id + 1, packet->dest - 2, packet->seq_num);
-                        xQueueSend(receiver_queues[packet->dest - 3], &packet, portMAX_DELAY);
-                    } else {
-                        // Handle invalid destination by logging and freeing the packet
-                        printf("Switch: Invalid dest %d from sender %d for seq %u\n",
-                               packet->dest - 2, packet->sender_id + 1, packet->seq_num);
-                        vPortFree(packet);
-                    }
-                }
-            }
+        // Forward every packet whose delay has elapsed
+        TickType_t now = xTaskGetTickCount();
+        while (delay_line.count > 0 && !tick_before(now, delay_line.items[0].release)) {
+            switch_forward(delay_line_pop(&delay_line), trace);
+        }
+
+        // Sleep until the next packet is due; if nothing is delayed, until a packet arrives
+        TickType_t wait = portMAX_DELAY;
+        if (delay_line.count > 0) {
+            wait = delay_line.items[0].release - now;
+        }
+        if (delay_line.count == delay_line.capacity) {
+            // Delay line full: leave new packets in the sender queues until one leaves
+            vTaskDelay(wait);
+            continue;
+        }
+
+        QueueSetMemberHandle_t ready = xQueueSelectFromSet(switch_input_set, wait);
+        if (ready == NULL || xQueueReceive(ready, &packet, 0) != pdTRUE) {
+            continue; // Timed out: a delayed packet is due
+        }
+        PortStats_t *port = &net_switch.stats[packet->sender_id]; // Input port of the packet's sender
+        port_count_rx(port, packet, uxQueueMessagesWaiting(ready));
+
+        // Apply a 1% probability to drop the packet
+        if (sim_chance(&rng, DROP_PROBABILITY)) {
+            TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_DROPPED, packet, 0);
+            port->dropped++;
+            packet_free(&pools, packet); // Return the dropped packet to the pool
+        } else {
+            delay_line_push(&delay_line, packet, xTaskGetTickCount() + pdMS_TO_TICKS(SWITCH_DELAY_MS));
         }
-        taskYIELD(); // Yield to allow other tasks to run
     }
 }
 
 // Receiver task: processes incoming packets, tracks losses, and stops at a configurable number of packets (200 for this phase)
 void ReceiverTask(void *pvParameters) {
-    int receiver_id = (int)pvParameters + 3;    // Receiver ID (3 or 4)
-    int queue_idx = receiver_id - 3;            // Queue index (0 or 1)
+    int receiver_id = (int)pvParameters + RECEIVER_ADDRESS_BASE; // Receiver address (3 and up)
+    int queue_idx = (int)pvParameters;          // Queue index (0 to num_receivers - 1)
     Packet_t *packet;                           // Pointer to the received packet
-    static int receivers_done = 0;              // Counter for receivers that have finished
+    TraceRing_t *trace = &trace_rings[num_senders + 1 + queue_idx]; // This receiver's trace events
+    static int receivers_done = 0;              // Counter for receivers that have finished, shared by all
 
     while (1) {
         // Receive a packet from the queue (blocks until a packet arrives)
         if (xQueueReceive(receiver_queues[queue_idx], &packet, portMAX_DELAY) == pdTRUE) {
+            int finished = 0;                   // This packet was the last one to count
             // Check if the packet was sent to the wrong receiver
             if (packet->dest != receiver_id) {
-                printf("Receiver %d: Error - received packet for dest %d from sender %d, seq %u\n",
-                       receiver_id - 2, packet->dest - 2, packet->sender_id + 1, packet->seq_num);
+                TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_WRONG_RECEIVER, packet, queue_idx);
             } else {
                 // Process packets until the receiver reaches the specified number (200 for this phase)
-                if (receiver_counts[queue_idx] < packets_to_stop) {
-                    receiver_counts[queue_idx]++;
-                    // Detect lost packets by checking for sequence number gaps
-                    uint32_t expected_seq = last_seq[queue_idx][packet->sender_id] + 1;
-                    if (packet->seq_num > expected_seq) {
-                        receiver_lost[queue_idx] += packet->seq_num - expected_seq;
-                        printf("Receiver %d: Detected %u lost packets from sender %d\n",
-                               receiver_id - 2, packet->seq_num - expected_seq, packet->sender_id + 1);
-                    }
-                    last_seq[queue_idx][packet->sender_id] = packet->seq_num;
-                    // Log the received packet (Receiver 1/2, Sender 1/2)
-                    printf("Receiver %d: Received packet from sender %d, seq %u, total %u, lost %u\n",
-                           receiver_id - 2, packet->sender_id + 1, packet->seq_num,
-                           receiver_counts[queue_idx], receiver_lost[queue_idx]);
-
-                    // If the specified number of packets is received, print final stats and stop
-                    if (receiver_counts[queue_idx] >= packets_to_stop) {
-                        printf("Receiver %d: Final stats - total %u, lost %u\n",
-                               receiver_id - 2, receiver_counts[queue_idx], receiver_lost[queue_idx]);
-                        receivers_done++;
-                        // Signal completion when both receivers are done
-                        if (receivers_done == NUM_RECEIVERS) {
-                            xSemaphoreGive(simulation_done_sem);
-                        }
-                        vTaskSuspend(NULL); // Suspend this receiver task
+                ReceiverStats_t *stats = &receiver_stats[queue_idx];
+                if (stats->count < packets_to_stop) {
+                    // Count the packet and detect lost packets by checking for sequence number gaps
+                    uint32_t missing = receiver_accept(stats, packet);
+                    if (missing) {
+                        TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_LOST, packet, missing);
                     }
+                    // Record the received packet (Receiver 1/2, Sender 1/2)
+                    TRACE_PACKET(trace, xTaskGetTickCount(), TRACE_RECEIVED, packet, 0);
+
+                    finished = stats->count >= packets_to_stop;
+                }
+            }
+            packet_free(&pools, packet); // Return the processed packet to the pool, the only free path
+
+            // If the specified number of packets is received, stop; the terminator prints the final stats
+            if (finished) {
+                // Another receiver can preempt a plain increment, so count in a critical
+                // section; the last receiver to finish signals completion
+                taskENTER_CRITICAL();
+                int done = ++receivers_done;
+                taskEXIT_CRITICAL();
+                if (done == num_receivers) {
+                    xSemaphoreGive(simulation_done_sem);
                 }
+                vTaskSuspend(NULL); // Suspend this receiver task
             }
-            vPortFree(packet); // Free the processed packet
+        }
+    }
+}
+
+// Prints one decoded trace event to the console
+void trace_console(void *context, const TraceEvent_t *e) {
+    trace_print(stdout, e);
+}
+
+// Trace task: runs below every simulation task and decodes their trace rings to the console,
+// so formatting and console output happen only when the simulation has nothing to do.
+// The terminator wakes it for a last pass once the simulation tasks are stopped.
+void TraceTask(void *pvParameters) {
+    uint32_t rings = num_senders + 1 + num_receivers;
+    while (1) {
+        uint32_t final_pass = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TRACE_DRAIN_MS));
+        trace_drain(trace_rings, rings, trace_console, NULL);
+        if (final_pass) {
+            uint32_t overruns = trace_overruns(trace_rings, rings);
+            if (overruns) {
+                printf("Trace: %u events lost to full rings\n", (unsigned)overruns);
+            }
+            xTaskNotifyGive(terminator_handle); // Every event is printed
+            vTaskSuspend(NULL);
         }
     }
 }
 
 // Terminator task: waits for the simulation to complete and suspends all tasks
 void TerminatorTask(void *pvParameters) {
-    // Wait for both receivers to finish (semaphore is triggered when done)
+    // Wait for every receiver to finish (semaphore is triggered when done)
     if (xSemaphoreTake(simulation_done_sem, portMAX_DELAY) == pdTRUE) {
-        printf("Simulation complete. Suspending all tasks.\n");
+        TickType_t elapsed = xTaskGetTickCount();
         // Suspend all sender tasks
-        for (int i = 0; i < NUM_SENDERS; i++) {
+        for (int i = 0; i < num_senders; i++) {
             vTaskSuspend(sender_handles[i]);
         }
         // Suspend the switch task
         vTaskSuspend(switch_handle);
         // Suspend the receiver tasks (already stopped, but ensure they remain suspended)
-        for (int i = 0; i < NUM_RECEIVERS; i++) {
+        for (int i = 0; i < num_receivers; i++) {
             vTaskSuspend(receiver_handles[i]);
         }
+        // Let the trace task print the events still in the rings, then print the results
+        xTaskNotifyGive(trace_handle);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        printf("Simulation complete. Suspending all tasks.\n");
+        for (int i = 0; i < num_receivers; i++) {
+            printf("Receiver %d: Final stats - total %u, lost %u\n",
+                   i + 1, receiver_stats[i].count, receiver_stats[i].lost);
+        }
+        switch_print_stats(&net_switch, elapsed * portTICK_PERIOD_MS, num_senders + num_receivers <= 16);
+        pool_print_stats("Packet", &pools.packet_pool);
+        pool_print_stats("Payload", &pools.payload_pool);
         vTaskSuspend(NULL); // Suspend the terminator task itself
     }
 }
@@ -204,12 +296,66 @@ void main(void) {
     // Print to confirm that the main function is running
     printf("Starting simulation...\n");
 
+#ifdef SIM_SEED
+    // Fixed seed: the tasks draw the same random numbers as netsim_host --seed SIM_SEED
+    run_seed = SIM_SEED;
+#else
     // Static counter to ensure a unique random seed for each run
     static uint32_t run_counter = 0;
     // Combine tick count with the counter to create a dynamic seed
-    uint32_t seed = xTaskGetTickCount() + run_counter++;
-    printf("Random seed: %u\n", seed); // Print the seed to verify it changes each run
-    srand(seed);
+    run_seed = xTaskGetTickCount() + run_counter++;
+#endif
+    printf("Random seed: %u\n", run_seed); // Print the seed to verify it changes each run
+
+    // Size every per-port table for the configured switch, once, before any task runs
+    delay_line_length = 8 * (num_senders + num_receivers);
+    uint32_t blocks = POOL_BLOCKS(num_senders, num_receivers, QUEUE_LENGTH, delay_line_length);
+    if (blocks >= POOL_NONE) {
+        printf("Switch too large: %u packets do not fit 16-bit pool indices\n", (unsigned)blocks);
+        return;
+    }
+    sender_queues = alloc_table(num_senders, sizeof(QueueHandle_t));
+    receiver_queues = alloc_table(num_receivers, sizeof(QueueHandle_t));
+    sender_handles = alloc_table(num_senders, sizeof(TaskHandle_t));
+    receiver_handles = alloc_table(num_receivers, sizeof(TaskHandle_t));
+    receiver_stats = alloc_table(num_receivers, sizeof(ReceiverStats_t));
+    uint16_t *route = alloc_table(SWITCH_ROUTES(num_receivers), sizeof(uint16_t));
+    PortStats_t *port_stats = alloc_aligned_table(num_senders + num_receivers, sizeof(PortStats_t),
+                                                  __alignof__(PortStats_t)); // One cache line per port
+    DelayedPacket_t *delayed = alloc_table(delay_line_length, sizeof(DelayedPacket_t));
+    pools.packets = alloc_table(blocks, sizeof(Packet_t));
+    uint32_t payload_blocks = SENDER_ATTACH_PAYLOAD
+        ? payload_pool_blocks(PAYLOAD_POOL_BLOCKS, num_senders, num_receivers, QUEUE_LENGTH, blocks) : 0;
+    pools.payloads = payload_blocks ? alloc_table(payload_blocks, PAYLOAD_SIZE) : NULL; // Zeroed once; nobody writes payloads
+    uint16_t *packet_free_list = alloc_table(blocks, sizeof(uint16_t));
+    uint16_t *payload_free_list = payload_blocks ? alloc_table(payload_blocks, sizeof(uint16_t)) : NULL;
+    trace_rings = alloc_table(num_senders + 1 + num_receivers, sizeof(TraceRing_t));
+    if (!trace_rings || !sender_queues || !receiver_queues || !sender_handles || !receiver_handles || !receiver_stats ||
+        !route || !port_stats || !delayed || !pools.packets || !packet_free_list ||
+        (payload_blocks && (!pools.payloads || !payload_free_list))) {
+        printf("Failed to allocate tables for %u senders and %u receivers\n", num_senders, num_receivers);
+        return;
+    }
+    for (int i = 0; i < num_receivers; i++) {
+        receiver_stats[i].last_seq = alloc_table(num_senders, sizeof(uint32_t));
+        if (!receiver_stats[i].last_seq) {
+            printf("Failed to allocate receiver %d stats\n", i + 1);
+            return;
+        }
+    }
+    switch_init(&net_switch, num_senders, num_receivers, route, port_stats);
+    for (int i = 0; i < num_senders + 1 + num_receivers; i++) {
+        TraceEvent_t *events = alloc_table(TRACE_RING_LENGTH, sizeof(TraceEvent_t));
+        if (!events) {
+            printf("Failed to allocate trace ring %d\n", i);
+            return;
+        }
+        trace_init(&trace_rings[i], events, TRACE_RING_LENGTH);
+    }
+
+    // Set up the packet pools before any task can allocate
+    pool_init(&pools.packet_pool, packet_free_list, blocks);
+    pool_init(&pools.payload_pool, payload_free_list, (uint16_t)payload_blocks);
 
     // Create a binary semaphore for simulation termination
     simulation_done_sem = xSemaphoreCreateBinary();
@@ -219,17 +365,27 @@ void main(void) {
     }
 
     // Initialize sender queues (one per sender)
-    for (int i = 0; i < NUM_SENDERS; i++) {
-        sender_queues[i] = xQueueCreate(20, sizeof(Packet_t *));
+    for (int i = 0; i < num_senders; i++) {
+        sender_queues[i] = xQueueCreate(QUEUE_LENGTH, sizeof(Packet_t *));
         if (!sender_queues[i]) {
             printf("Failed to create sender queue %d\n", i);
             return;
         }
     }
 
+    // Put the sender queues in one queue set so the switch can block on all of them
+    switch_input_set = xQueueCreateSet(num_senders * QUEUE_LENGTH);
+    if (!switch_input_set) {
+        printf("Failed to create switch input queue set\n");
+        return;
+    }
+    for (int i = 0; i < num_senders; i++) {
+        xQueueAddToSet(sender_queues[i], switch_input_set);
+    }
+
     // Initialize receiver queues (one per receiver)
-    for (int i = 0; i < NUM_RECEIVERS; i++) {
-        receiver_queues[i] = xQueueCreate(20, sizeof(Packet_t *));
+    for (int i = 0; i < num_receivers; i++) {
+        receiver_queues[i] = xQueueCreate(QUEUE_LENGTH, sizeof(Packet_t *));
         if (!receiver_queues[i]) {
             printf("Failed to create receiver queue %d\n", i);
             return;
@@ -237,7 +393,7 @@ void main(void) {
     }
 
     // Create sender tasks and store their handles
-    for (int i = 0; i < NUM_SENDERS; i++) {
+    for (int i = 0; i < num_senders; i++) {
         char name[16];
         snprintf(name, sizeof(name), "Sender%d", i + 1);
         xTaskCreate(SenderTask, name, 512, (void *)i,
@@ -245,11 +401,11 @@ void main(void) {
     }
 
     // Create the switch task and store its handle
-    xTaskCreate(SwitchTask, "Switch", 512, NULL,
+    xTaskCreate(SwitchTask, "Switch", 512, delayed,
                 tskIDLE_PRIORITY + 1, &switch_handle);
 
     // Create receiver tasks and store their handles
-    for (int i = 0; i < NUM_RECEIVERS; i++) {
+    for (int i = 0; i < num_receivers; i++) {
         char name[16];
         snprintf(name, sizeof(name), "Receiver%d", i + 1);
         xTaskCreate(ReceiverTask, name, 512, (void *)i,
@@ -260,6 +416,10 @@ void main(void) {
     xTaskCreate(TerminatorTask, "Terminator", 512, NULL,
                 tskIDLE_PRIORITY + 3, &terminator_handle);
 
+    // Create the trace task below every other task so decoding never delays the simulation
+    xTaskCreate(TraceTask, "Trace", 512, NULL,
+                tskIDLE_PRIORITY, &trace_handle);
+
     // Start the FreeRTOS scheduler
     vTaskStartScheduler();
 
@@ -1,10 +1,174 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <memory>
+#include "include/AsyncAI.h"
 #include "include/Game.h"
+#include "include/GameServer.h"
+#include "include/SelfPlay.h"
+#include "include/Tablebase.h"
+#include "include/Telemetry.h"
 #include "include/User.h"
 
 
+namespace {
+
+GameServer* runningServer = nullptr;
+
+// stop() only stores a flag and writes to an eventfd, both signal safe
+void stopServer(int) {
+    if (runningServer) runningServer->stop();
+}
+
+// "-" is stdout
+void dumpTelemetry(const Telemetry& telemetry, const std::string& path) {
+    if (path == "-") {
+        std::cout << telemetry.toJson() << "\n";
+        return;
+    }
+    std::ofstream out(path, std::ios::trunc);
+    out << telemetry.toJson() << "\n";
+    if (!out) std::cerr << "cannot write " << path << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Optional variant flags: --size N --win K --time-ms T --threads T --ai table|tree|search|mcts
+    // Headless batch mode: --selfplay GAMES [--x PLAYER] [--o PLAYER] [--seed S],
+    // where PLAYER is random or one of the --ai backends
+    // Server mode: --serve PORT | --serve-unix PATH [--workers N] [--users FILE]
+    // Offline solver: --solve FILE [--size N --win K --threads T --min-pieces P]
+    // Any mode: --record FILE appends every finished game to a record file,
+    // --tablebase FILE lets the search play solved positions perfectly,
+    // --telemetry-json FILE|- writes per-backend AI move costs on exit
+    int size = 3, winLength = 3, timeMs = 500, threads = 1;
+    AIMode aiMode = AIMode::Table;
+    SelfPlayConfig selfPlay;
+    selfPlay.games = 0;
+    ServerConfig server;
+    server.port = -1;
+    std::string usersFile;
+    std::string recordFile;
+    std::string tablebaseFile;
+    std::string telemetryFile;
+    SolveConfig solve;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        PlayerSpec spec;
+        if (!std::strcmp(argv[i], "--size")) size = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--win")) winLength = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--time-ms")) timeMs = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--threads")) threads = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--ai") && parsePlayer(argv[i + 1], spec) && !spec.random) aiMode = spec.mode;
+        else if (!std::strcmp(argv[i], "--selfplay")) selfPlay.games = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--x")) parsePlayer(argv[i + 1], selfPlay.x);
+        else if (!std::strcmp(argv[i], "--o")) parsePlayer(argv[i + 1], selfPlay.o);
+        else if (!std::strcmp(argv[i], "--seed")) selfPlay.seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--serve")) server.port = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--serve-unix")) server.unixPath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--workers")) server.workers = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--users")) usersFile = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--record")) recordFile = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--tablebase")) tablebaseFile = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--telemetry-json")) telemetryFile = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--solve")) solve.path = argv[i + 1];
+        else if (!std::strcmp(argv[i], "--min-pieces")) solve.minPieces = std::atoi(argv[i + 1]);
+    }
+    if (size < 3 || size > MAX_BOARD_SIZE) size = 3;
+    if (winLength < 3 || winLength > size) winLength = size;
+
+    if (!solve.path.empty()) {
+        solve.size = size;
+        solve.winLength = winLength;
+        solve.threads = threads > 1 ? threads : 0;
+        SolveStats stats;
+        std::string error;
+        if (!solveTablebase(solve, stats, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::cout << size << "x" << size << " k" << winLength << ": " << stats.positions << " entries ("
+                  << stats.wins << " wins, " << stats.draws << " draws, " << stats.losses
+                  << " losses for the side to move), " << stats.bytes << " bytes in " << stats.seconds << " s\n";
+        return 0;
+    }
+
+    // Mapped once and shared read-only by every engine
+    Tablebase tablebase;
+    if (!tablebaseFile.empty()) {
+        std::string error;
+        if (!tablebase.open(tablebaseFile, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        selfPlay.searchLimits.tablebase = &tablebase;
+        server.searchLimits.tablebase = &tablebase;
+    }
+
+    std::unique_ptr<Telemetry> telemetry;
+    if (!telemetryFile.empty()) {
+        telemetry.reset(new Telemetry);
+        selfPlay.telemetry = telemetry.get();
+        server.telemetry = telemetry.get();
+    }
+
+    std::unique_ptr<GameRecordWriter> recorder;
+    if (!recordFile.empty()) {
+        recorder.reset(new GameRecordWriter(recordFile));
+        if (!recorder->isOpen()) {
+            std::cerr << "cannot open " << recordFile << "\n";
+            return 1;
+        }
+    }
+
+    if (selfPlay.games > 0) {
+        // --threads here is the number of games played at once
+        selfPlay.size = size;
+        selfPlay.winLength = winLength;
+        selfPlay.threads = threads > 1 ? threads : 0;
+        selfPlay.searchLimits.timeBudgetMs = timeMs;
+        selfPlay.mctsLimits.timeBudgetMs = timeMs;
+        selfPlay.recorder = recorder.get();
+        SelfPlayStats stats = runSelfPlay(selfPlay);
+        std::cout << size << "x" << size << " k" << winLength << ", X " << playerName(selfPlay.x)
+                  << " vs O " << playerName(selfPlay.o) << "\n"
+                  << "games " << stats.games << ": X wins " << stats.xWins << ", O wins " << stats.oWins
+                  << ", draws " << stats.draws << "\n"
+                  << "moves " << stats.moves << " in " << stats.seconds << " s, "
+                  << stats.gamesPerSec() << " games/s, " << stats.movesPerSec() << " moves/s\n";
+        if (telemetry) dumpTelemetry(*telemetry, telemetryFile);
+        return 0;
+    }
+
+    if (server.port >= 0 || !server.unixPath.empty()) {
+        // Each AI move runs single threaded; the workers give the parallelism
+        server.searchLimits.timeBudgetMs = timeMs;
+        server.mctsLimits.timeBudgetMs = timeMs;
+        server.recorder = recorder.get();
+        UserStore users = usersFile.empty() ? UserStore() : UserStore(usersFile, usersFile + ".snapshot");
+        GameServer gameServer(server, users);
+        std::string error;
+        if (!gameServer.start(error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        if (server.unixPath.empty()) std::cout << "listening on 127.0.0.1:" << gameServer.port() << "\n";
+        else std::cout << "listening on " << server.unixPath << "\n";
+        std::cout.flush();
+        runningServer = &gameServer;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        gameServer.run();
+        runningServer = nullptr;
+        if (telemetry) dumpTelemetry(*telemetry, telemetryFile);
+        return 0;
+    }
 
-int main() {
     User user;
     int choice;
     std::string username, password;
@@ -27,17 +191,36 @@ int main() {
     std::cout << "\nChoose Game Mode:\n1. Two Players\n2. Play vs AI\n> ";
     std::cin >> mode;
     
-    Game game;
+    Game game(size, winLength);
+    SearchLimits limits;
+    limits.timeBudgetMs = timeMs;
+    limits.threads = threads;
+    limits.tablebase = tablebase.isOpen() ? &tablebase : nullptr;
+    game.setSearchLimits(limits);
+    MctsLimits mctsLimits;
+    mctsLimits.timeBudgetMs = timeMs;
+    mctsLimits.threads = threads;
+    game.setMctsLimits(mctsLimits);
+    game.setAIMode(aiMode);
+    game.setTelemetry(telemetry.get());
+    if (mode == 2) game.setRecorder(recorder.get(), 0, 1 + uint32_t(aiMode));
+    else game.setRecorder(recorder.get());
+    std::unique_ptr<AsyncAI> ai;
+    if (mode == 2) ai.reset(new AsyncAI(game));
     int row, col;
     
     while (true) {
         game.displayBoard();
     
         if (mode == 2 && game.getCurrentPlayer() == 'O') {
-            std::cout << "AI is thinking...\n";
-            game.makeAIMoveWithTree();
+            // Often already answered by pondering during the human's turn
+            std::future<int> reply = ai->requestMove();
+            if (reply.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                std::cout << "AI is thinking...\n";
+            reply.get();
 
         } else {
+            if (mode == 2) ai->startPondering();
             std::cout << "Player " << game.getCurrentPlayer() << ", enter your move (row and col): ";
             std::cin >> row >> col;
     
@@ -62,7 +245,8 @@ int main() {
         game.switchPlayer();
     }
     
-    
+    ai.reset(); // stops any pondering before the game goes away
+    if (telemetry) dumpTelemetry(*telemetry, telemetryFile);
     return 0;
 }
 
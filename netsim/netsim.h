@@ -0,0 +1,421 @@
+// Network simulation model shared by the FreeRTOS build (main.c) and the Linux
+// discrete-event host (netsim_host.c): packet format, packet pools, the switch
+// delay line, the random source, and what the sender, switch and receiver decide
+// for each packet. The two programs only differ in how time passes and how tasks block.
+#ifndef NETSIM_H
+#define NETSIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Constants used for the packet structure and simulation settings
+#define PACKET_SIZE 1000            // Packet size set to 1000 bytes as requirements
+#define SENDER_PERIOD_MS 200        // Sender generates packets every 200 milliseconds
+#define SWITCH_DELAY_MS 200         // Switch delays forwarding by 200 milliseconds
+#define DROP_PROBABILITY 0.01       // 1% probability for packet drop
+#define NUM_SENDERS 2               // Default number of sender tasks is 2
+#define NUM_RECEIVERS 2             // Default number of receiver tasks is 2
+#define RECEIVER_ADDRESS_BASE 3     // Receiver r has destination address 3 + r (displayed as r + 1 in logs)
+#define PACKETS_PER_RECEIVER 200    // Default number of packets for each receiver to stop at; can be changed
+#define QUEUE_LENGTH 20             // Packets each sender and receiver queue holds
+#define DELAY_LINE_LENGTH 32        // Packets the default switch can hold in its 200ms delay at once (8 per port)
+#define SENDER_ATTACH_PAYLOAD 1     // 1: every packet carries a payload block, 0: header-only packets
+
+// Packet header size on the wire; the payload block holds the rest of the 1000 bytes
+#define PACKET_HEADER_SIZE (sizeof(uint32_t) + 3 * sizeof(uint16_t))
+#define PAYLOAD_SIZE (PACKET_SIZE - PACKET_HEADER_SIZE)
+
+// Most packets that can exist at once: full sender and receiver queues, a full delay line,
+// one held by each sender, one by the switch and one by each receiver between receiving and
+// freeing it. The pools are this big so allocation never fails.
+#define POOL_BLOCKS(senders, receivers, queue_length, delay_line_length) \
+    ((senders) * (queue_length) + (receivers) * (queue_length) + (delay_line_length) + (senders) + 1 + \
+     (receivers))
+#define POOL_PACKETS POOL_BLOCKS(NUM_SENDERS, NUM_RECEIVERS, QUEUE_LENGTH, DELAY_LINE_LENGTH)
+
+// Payload blocks are PAYLOAD_SIZE bytes each, so their pool is not sized for the worst case
+// above (over 100 KB at the default 2x2, while about 25 are ever in flight). A sender that
+// finds it empty skips that period, as for an empty descriptor pool. Define it as 0 to size
+// it like the descriptors; header-only runs (SENDER_ATTACH_PAYLOAD 0) allocate none. See
+// payload_pool_blocks for the smallest pool that still lets every receiver finish.
+#ifndef PAYLOAD_POOL_BLOCKS
+#define PAYLOAD_POOL_BLOCKS 32
+#endif
+#define POOL_NONE 0xFFFF            // Empty free list / packet without a payload block
+#define PORT_NONE 0xFFFF            // No route to the destination
+
+typedef uint32_t SimTick_t;         // Milliseconds, wrapping like the FreeRTOS tick count
+
+// Packet descriptor: the header fields plus the index of its payload block, so a packet
+// can move through the queues without anyone touching its 1000-byte payload
+typedef struct {
+    uint32_t seq_num;               // Sequence number for tracking packets
+    uint16_t length;                // Length of the packet (1000 bytes)
+    uint16_t dest;                  // Destination address (3 or 4 with two receivers, displayed as 1 or 2 in logs)
+    uint16_t sender_id;             // Sender ID (0 or 1 with two senders, displayed as 1 or 2 in logs)
+    uint16_t payload;               // Payload block index, POOL_NONE for a header-only packet
+    uint16_t block;                 // This descriptor's own index in the descriptor pool
+} Packet_t;
+
+// Fixed-block pool: a lock-free LIFO free list of block indices. The head packs the top
+// index (low 16 bits) with a tag bumped on every pop (high 16 bits), so a compare-and-swap
+// cannot succeed on a head that was popped and pushed back in between (the ABA problem).
+// Alloc and free are one CAS each and safe from any task or ISR.
+typedef struct {
+    volatile uint32_t head;         // Tag << 16 | index of the first free block
+    uint16_t *next;                 // Next free block after each free block, count entries
+    uint16_t count;                 // Blocks in the pool
+    volatile uint32_t in_use;       // Blocks currently allocated
+    volatile uint32_t peak;         // Most blocks ever allocated at once
+    volatile uint32_t allocs;       // Successful allocations
+    volatile uint32_t failures;     // Allocations that found the pool empty
+} BlockPool_t;
+
+// Descriptors and payload blocks of one simulation, each with its free list
+typedef struct {
+    Packet_t *packets;              // Descriptor storage
+    uint8_t (*payloads)[PAYLOAD_SIZE]; // Payload storage, zeroed once before the run
+    BlockPool_t packet_pool;        // Free list over packets
+    BlockPool_t payload_pool;       // Free list over payloads
+} PacketPools_t;
+
+// A packet waiting out the switch delay, ordered by the tick it may leave at
+typedef struct {
+    SimTick_t release;              // Tick at which the packet is forwarded
+    uint32_t order;                 // Arrival number; keeps packets with equal release ticks in FIFO order
+    Packet_t *packet;               // The delayed packet
+} DelayedPacket_t;
+
+// Time-ordered delay line: a binary min-heap on (release, order). Only the switch uses it.
+typedef struct {
+    DelayedPacket_t *items;         // Heap storage, capacity entries
+    uint32_t capacity;              // Packets the delay line can hold
+    uint32_t count;                 // Packets in the delay line
+    uint32_t next_order;            // Arrival number for the next packet
+} DelayLine_t;
+
+// Random source (xorshift32). Each task draws from its own stream, so the decisions a
+// task makes depend only on the seed and its stream number, not on how tasks interleave.
+typedef struct {
+    uint32_t state;
+} SimRandom_t;
+
+#define STREAM_SWITCH 0             // Random stream of the switch
+#define STREAM_SENDER(i) (1 + (i))  // Random stream of sender i
+
+// Per-receiver accounting
+typedef struct {
+    uint32_t count;                 // Packets received from all senders
+    uint32_t lost;                  // Packets found missing from sequence number gaps
+    uint32_t *last_seq;             // Last sequence number seen from each sender, one entry per sender
+} ReceiverStats_t;
+
+// Counters of one switch port, written only by the switch. Each port's counters fill one
+// cache line of their own, so updating a port touches a single line and ports never share one.
+typedef struct __attribute__((aligned(64))) {
+    uint32_t rx_packets;            // Packets taken from this port's input queue
+    uint32_t tx_packets;            // Packets put on this port's output queue
+    uint32_t dropped;               // Input packets lost to the drop probability
+    uint32_t overflow;              // Output packets lost to a full output queue
+    uint32_t invalid;               // Input packets with no route
+    uint32_t in_depth_peak;         // Most packets seen waiting in the input queue
+    uint32_t out_depth_peak;        // Most packets seen waiting in the output queue
+    uint64_t out_depth_sum;         // Output queue depth after each forward, for the mean
+    uint64_t rx_bytes;              // Bytes taken from the input queue
+    uint64_t tx_bytes;              // Bytes put on the output queue
+} PortStats_t;
+
+// Switch topology and forwarding table. Ports 0 .. senders - 1 face the senders (their
+// input queues carry traffic), ports senders .. ports - 1 face the receivers (their output
+// queues carry traffic). Both sizes are set when the switch is created.
+typedef struct {
+    uint16_t ports;                 // senders + receivers
+    uint16_t senders;
+    uint16_t receivers;
+    uint16_t route_count;           // Entries in route: every address below RECEIVER_ADDRESS_BASE + receivers
+    uint16_t *route;                // Forwarding table: destination address -> output port, PORT_NONE if unknown
+    PortStats_t *stats;             // One per port
+} Switch_t;
+
+#define SWITCH_ROUTES(receivers) (RECEIVER_ADDRESS_BASE + (receivers))
+
+// Payload blocks to allocate for a requested pool size (0 for one per descriptor), given the
+// descriptor pool's blocks. A receiver that has finished stops emptying its queue, so those
+// queues can pin receivers - 1 full queues of blocks for good; the pool keeps one more block
+// per sender on top, or the last receiver could starve.
+static inline uint32_t payload_pool_blocks(uint32_t requested, uint32_t senders, uint32_t receivers,
+                                           uint32_t queue_length, uint32_t blocks) {
+    uint32_t least = (receivers - 1) * queue_length + senders;
+    if (requested == 0 || requested > blocks) {
+        return blocks;
+    }
+    return requested < least ? least : requested;
+}
+
+// Chains all blocks into the free list and clears the statistics
+static inline void pool_init(BlockPool_t *pool, uint16_t *next, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        next[i] = (i + 1 < count) ? i + 1 : POOL_NONE;
+    }
+    pool->next = next;
+    pool->count = count;
+    pool->head = count ? 0 : POOL_NONE;
+    pool->in_use = pool->peak = pool->allocs = pool->failures = 0;
+}
+
+// Pops a free block index, or returns POOL_NONE when the pool is empty
+static inline uint16_t pool_alloc(BlockPool_t *pool) {
+    uint32_t old_head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+    uint32_t new_head;
+    uint16_t index;
+    do {
+        index = old_head & 0xFFFF;
+        if (index == POOL_NONE) {
+            __atomic_fetch_add(&pool->failures, 1, __ATOMIC_RELAXED);
+            return POOL_NONE;
+        }
+        // A stale next[] read is harmless: the tag makes the CAS fail and we retry
+        new_head = ((old_head + 0x10000) & 0xFFFF0000) | pool->next[index];
+    } while (!__atomic_compare_exchange_n(&pool->head, &old_head, new_head, 1,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    uint32_t used = __atomic_add_fetch(&pool->in_use, 1, __ATOMIC_RELAXED);
+    uint32_t peak = __atomic_load_n(&pool->peak, __ATOMIC_RELAXED);
+    while (used > peak && !__atomic_compare_exchange_n(&pool->peak, &peak, used, 1,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    __atomic_fetch_add(&pool->allocs, 1, __ATOMIC_RELAXED);
+    return index;
+}
+
+// Pushes a block index back onto the free list
+static inline void pool_free(BlockPool_t *pool, uint16_t index) {
+    uint32_t old_head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED);
+    uint32_t new_head;
+    do {
+        pool->next[index] = old_head & 0xFFFF;
+        new_head = (old_head & 0xFFFF0000) | index;
+    } while (!__atomic_compare_exchange_n(&pool->head, &old_head, new_head, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    __atomic_fetch_sub(&pool->in_use, 1, __ATOMIC_RELAXED);
+}
+
+// Prints the occupancy statistics of a pool
+static inline void pool_print_stats(const char *name, const BlockPool_t *pool) {
+    printf("%s pool: %u blocks, in use %u, peak %u, allocs %u, failures %u\n", name,
+           (unsigned)pool->count, (unsigned)pool->in_use, (unsigned)pool->peak,
+           (unsigned)pool->allocs, (unsigned)pool->failures);
+}
+
+// Takes a descriptor from the pools, with a payload block if requested; NULL when empty
+static inline Packet_t *packet_alloc(PacketPools_t *pools, int with_payload) {
+    uint16_t block = pool_alloc(&pools->packet_pool);
+    if (block == POOL_NONE) {
+        return NULL;
+    }
+    Packet_t *packet = &pools->packets[block];
+    packet->block = block;
+    packet->payload = POOL_NONE;
+    if (with_payload) {
+        packet->payload = pool_alloc(&pools->payload_pool);
+        if (packet->payload == POOL_NONE) {
+            pool_free(&pools->packet_pool, block);
+            return NULL;
+        }
+    }
+    return packet;
+}
+
+// Returns a packet and its payload block (if any) to the pools
+static inline void packet_free(PacketPools_t *pools, Packet_t *packet) {
+    if (packet->payload != POOL_NONE) {
+        pool_free(&pools->payload_pool, packet->payload);
+    }
+    pool_free(&pools->packet_pool, packet->block);
+}
+
+// Payload bytes of a packet, NULL for a header-only packet
+static inline uint8_t *packet_data(PacketPools_t *pools, Packet_t *packet) {
+    return packet->payload == POOL_NONE ? NULL : pools->payloads[packet->payload];
+}
+
+// True if tick a comes before tick b; correct across tick counter wrap-around
+static inline int tick_before(SimTick_t a, SimTick_t b) {
+    return (SimTick_t)(a - b) > 0x7FFFFFFFu;
+}
+
+// True if delayed packet a leaves before delayed packet b
+static inline int delayed_before(const DelayedPacket_t *a, const DelayedPacket_t *b) {
+    if (a->release != b->release) {
+        return tick_before(a->release, b->release);
+    }
+    return (int32_t)(a->order - b->order) < 0;
+}
+
+static inline void delay_line_init(DelayLine_t *line, DelayedPacket_t *items, uint32_t capacity) {
+    line->items = items;
+    line->capacity = capacity;
+    line->count = 0;
+    line->next_order = 0;
+}
+
+// Adds a packet to the delay line; the caller checks there is room
+static inline void delay_line_push(DelayLine_t *line, Packet_t *packet, SimTick_t release) {
+    uint32_t i = line->count++;
+    DelayedPacket_t item = { release, line->next_order++, packet };
+    // Sift up: move parents that leave later down one level
+    while (i > 0 && delayed_before(&item, &line->items[(i - 1) / 2])) {
+        line->items[i] = line->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    line->items[i] = item;
+}
+
+// Removes and returns the packet that leaves first; the caller checks the line is not empty
+static inline Packet_t *delay_line_pop(DelayLine_t *line) {
+    Packet_t *packet = line->items[0].packet;
+    DelayedPacket_t last = line->items[--line->count];
+    uint32_t i = 0;
+    // Sift down: move the earlier child up until last fits
+    while (2 * i + 1 < line->count) {
+        uint32_t child = 2 * i + 1;
+        if (child + 1 < line->count && delayed_before(&line->items[child + 1], &line->items[child])) {
+            child++;
+        }
+        if (!delayed_before(&line->items[child], &last)) {
+            break;
+        }
+        line->items[i] = line->items[child];
+        i = child;
+    }
+    line->items[i] = last;
+    return packet;
+}
+
+// Seeds one task's stream; different streams of one seed are unrelated
+static inline void sim_seed(SimRandom_t *rng, uint32_t seed, uint32_t stream) {
+    uint32_t z = seed + 0x9E3779B9u * (stream + 1);
+    z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+    z ^= z >> 16;
+    rng->state = z ? z : 1;
+}
+
+static inline uint32_t sim_random(SimRandom_t *rng) {
+    uint32_t x = rng->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng->state = x;
+}
+
+// True with the given probability
+static inline int sim_chance(SimRandom_t *rng, double probability) {
+    return (sim_random(rng) >> 8) * (1.0 / 16777216.0) < probability;
+}
+
+// Sender: fills in the next packet for a random receiver; seq_nums has one entry per receiver
+static inline void sender_make_packet(Packet_t *packet, int sender_id, uint32_t *seq_nums,
+                                      uint16_t receivers, SimRandom_t *rng) {
+    uint16_t receiver = (uint16_t)(sim_random(rng) % receivers);
+    packet->dest = RECEIVER_ADDRESS_BASE + receiver;
+    packet->seq_num = seq_nums[receiver]++;
+    packet->length = PACKET_SIZE;
+    packet->sender_id = (uint16_t)sender_id;
+}
+
+// Sets up the topology and a forwarding table that sends each receiver's address to its port.
+// route needs SWITCH_ROUTES(receivers) entries and stats senders + receivers.
+static inline void switch_init(Switch_t *sw, uint16_t senders, uint16_t receivers,
+                               uint16_t *route, PortStats_t *stats) {
+    sw->ports = senders + receivers;
+    sw->senders = senders;
+    sw->receivers = receivers;
+    sw->route_count = SWITCH_ROUTES(receivers);
+    sw->route = route;
+    sw->stats = stats;
+    for (uint32_t address = 0; address < sw->route_count; address++) {
+        route[address] = address >= RECEIVER_ADDRESS_BASE ? senders + (address - RECEIVER_ADDRESS_BASE) : PORT_NONE;
+    }
+    for (uint32_t port = 0; port < sw->ports; port++) {
+        PortStats_t zero = { 0 };
+        stats[port] = zero;
+    }
+}
+
+// Output port for a packet, PORT_NONE if its destination has no route
+static inline uint16_t switch_route(const Switch_t *sw, const Packet_t *packet) {
+    return packet->dest < sw->route_count ? sw->route[packet->dest] : PORT_NONE;
+}
+
+// Counts a packet taken from an input port that still had depth packets waiting
+static inline void port_count_rx(PortStats_t *port, const Packet_t *packet, uint32_t depth) {
+    port->rx_packets++;
+    port->rx_bytes += packet->length;
+    if (depth + 1 > port->in_depth_peak) {
+        port->in_depth_peak = depth + 1;
+    }
+}
+
+// Counts a packet put on an output port that now holds depth packets
+static inline void port_count_tx(PortStats_t *port, const Packet_t *packet, uint32_t depth) {
+    port->tx_packets++;
+    port->tx_bytes += packet->length;
+    port->out_depth_sum += depth;
+    if (depth > port->out_depth_peak) {
+        port->out_depth_peak = depth;
+    }
+}
+
+// Prints totals over all ports, and one line per port if per_port is set. elapsed_ms is the
+// simulated time the counters cover.
+static inline void switch_print_stats(const Switch_t *sw, uint64_t elapsed_ms, int per_port) {
+    uint64_t rx = 0, tx = 0, dropped = 0, overflow = 0, invalid = 0, depth_sum = 0, tx_bytes = 0;
+    uint32_t in_peak = 0, out_peak = 0;
+    double seconds = elapsed_ms ? elapsed_ms / 1000.0 : 1.0;
+    if (per_port) {
+        printf("%5s %6s %10s %10s %8s %8s %7s %8s %8s %9s\n", "port", "side", "rx", "tx", "dropped",
+               "overflow", "invalid", "in peak", "out peak", "tx pkt/s");
+    }
+    for (uint32_t p = 0; p < sw->ports; p++) {
+        const PortStats_t *port = &sw->stats[p];
+        rx += port->rx_packets;
+        tx += port->tx_packets;
+        dropped += port->dropped;
+        overflow += port->overflow;
+        invalid += port->invalid;
+        depth_sum += port->out_depth_sum;
+        tx_bytes += port->tx_bytes;
+        if (port->in_depth_peak > in_peak) in_peak = port->in_depth_peak;
+        if (port->out_depth_peak > out_peak) out_peak = port->out_depth_peak;
+        if (per_port) {
+            printf("%5u %6s %10u %10u %8u %8u %7u %8u %8u %9.2f\n", (unsigned)p, p < sw->senders ? "sender" : "recv",
+                   (unsigned)port->rx_packets, (unsigned)port->tx_packets, (unsigned)port->dropped,
+                   (unsigned)port->overflow, (unsigned)port->invalid, (unsigned)port->in_depth_peak,
+                   (unsigned)port->out_depth_peak, port->tx_packets / seconds);
+        }
+    }
+    printf("Switch: %u ports (%u senders, %u receivers), rx %llu, tx %llu, dropped %llu, overflow %llu, "
+           "invalid %llu, loss %.3f%%\n", (unsigned)sw->ports, (unsigned)sw->senders, (unsigned)sw->receivers,
+           (unsigned long long)rx, (unsigned long long)tx, (unsigned long long)dropped,
+           (unsigned long long)overflow, (unsigned long long)invalid,
+           rx ? 100.0 * (rx - tx) / rx : 0.0);
+    printf("Switch: throughput %.2f packets/s, %.0f bytes/s, output depth mean %.2f peak %u, input depth peak %u\n",
+           tx / seconds, tx_bytes / seconds, tx ? (double)depth_sum / tx : 0.0, (unsigned)out_peak, (unsigned)in_peak);
+}
+
+// Receiver: counts a packet and returns how many packets from its sender went missing
+// before it (sequence number gap)
+static inline uint32_t receiver_accept(ReceiverStats_t *stats, const Packet_t *packet) {
+    uint32_t missing = 0;
+    stats->count++;
+    uint32_t expected_seq = stats->last_seq[packet->sender_id] + 1;
+    if (packet->seq_num > expected_seq) {
+        missing = packet->seq_num - expected_seq;
+        stats->lost += missing;
+    }
+    stats->last_seq[packet->sender_id] = packet->seq_num;
+    return missing;
+}
+
+#endif // NETSIM_H
@@ -0,0 +1,532 @@
+// Discrete-event host for the network simulation: runs the Sender, Switch, Receiver and
+// Terminator logic of main.c on virtual time instead of FreeRTOS ticks, so a run takes as
+// long as its events, not its simulated seconds.
+//
+// Tasks take no time to run; time only passes between events. Every random decision comes
+// from the per-task streams of netsim.h, and events due at the same tick run in the order
+// they were scheduled, so a seed gives bit-identical results on every machine. The digest
+// printed at the end hashes every delivered packet with its arrival time.
+//
+// --verbose decodes the packet trace of trace.h into main.c's log lines as the run goes;
+// --trace FILE writes the raw events instead, and --decode FILE prints such a file later.
+//
+// usage: netsim_host [--seed N] [--packets N] [--drop P] [--delay MS] [--period MS]
+//                    [--queue N] [--delay-line N] [--receiver-ms MS] [--header-only]
+//                    [--payload-blocks N]
+//                    [--senders N] [--receivers N] [--ports N] [--port-stats]
+//                    [--until SECONDS] [--verbose] [--trace FILE]
+//        netsim_host --decode FILE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "netsim.h"
+#include "trace.h"
+
+typedef struct {
+    uint32_t seed;
+    uint32_t senders;               // Sender-facing switch ports
+    uint32_t receivers;             // Receiver-facing switch ports
+    uint32_t packets;               // Packets per receiver before the run stops
+    double drop;                    // Switch drop probability
+    uint32_t delay_ms;              // Switch forwarding delay
+    uint32_t period_ms;             // Sender period
+    uint32_t queue_length;          // Sender and receiver queue length
+    uint32_t delay_line_length;     // Packets the switch can delay at once, 0 for 8 per port
+    uint32_t receiver_ms;           // Time a receiver spends on each packet
+    int header_only;                // Packets carry no payload block
+    uint32_t payload_blocks;        // Payload pool size, 0 for one per descriptor (PAYLOAD_POOL_BLOCKS)
+    double until_s;                 // Virtual time limit, 0 for none
+    int verbose;                    // Print main.c's per-packet log lines
+    const char *trace_path;         // Write the binary packet trace here
+    int port_stats;                 // Print the counters of every port
+} Config;
+
+// Bounded FIFO of packets, standing in for a FreeRTOS queue
+typedef struct {
+    Packet_t **items;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+} Fifo;
+
+enum { EV_SENDER, EV_RELEASE, EV_RECEIVER };
+
+typedef struct {
+    uint64_t time;                  // Virtual milliseconds
+    uint64_t order;                 // Scheduling order, breaks ties between equal times
+    uint16_t type;
+    uint16_t id;                    // Sender or receiver index
+} Event;
+
+typedef struct {
+    Config cfg;
+    uint64_t now;                   // Virtual milliseconds since the start
+    PacketPools_t pools;
+
+    Event *events;                  // Min-heap on (time, order)
+    uint32_t event_count;
+    uint32_t event_capacity;
+    uint64_t next_order;
+    uint64_t events_run;
+
+    Fifo *sender_queues;            // Input queue of each sender port
+    uint16_t *input_set;            // The switch's queue set: sender ids in arrival order
+    uint32_t set_capacity, set_head, set_count;
+    uint32_t *seq_nums;             // Next sequence number per sender and receiver
+    SimRandom_t *sender_rng;
+    uint64_t *last_wake;
+    Packet_t **blocked;             // Packet waiting for room in a full sender queue, per sender
+    uint64_t generated;
+    uint64_t pool_empty;
+
+    Switch_t sw;
+    SimRandom_t switch_rng;
+    DelayLine_t delay_line;
+
+    Fifo *receiver_queues;          // Output queue of each receiver port
+    ReceiverStats_t *receiver_stats;
+    uint8_t *receiver_busy;
+    uint8_t *receiver_done;
+    uint32_t receivers_done;
+    uint64_t digest;
+
+    int tracing;                    // Record trace events: --verbose or --trace
+    TraceRing_t trace;              // Events of the current step, decoded after it
+    FILE *trace_file;
+} Sim;
+
+static void *xcalloc(size_t count, size_t size) {
+    void *p = calloc(count ? count : 1, size);
+    if (!p) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void fifo_init(Fifo *f, uint32_t capacity) {
+    f->items = xcalloc(capacity, sizeof(Packet_t *));
+    f->capacity = capacity;
+    f->head = f->count = 0;
+}
+
+// Cache-line aligned, as PortStats_t asks for
+static void *xaligned(size_t count, size_t size) {
+    size_t bytes = (count * size + 63) / 64 * 64;
+    void *p;
+    if (posix_memalign(&p, 64, bytes ? bytes : 64)) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return memset(p, 0, bytes);
+}
+
+static int fifo_push(Fifo *f, Packet_t *packet) {
+    if (f->count == f->capacity) {
+        return 0;
+    }
+    f->items[(f->head + f->count++) % f->capacity] = packet;
+    return 1;
+}
+
+static Packet_t *fifo_pop(Fifo *f) {
+    Packet_t *packet = f->items[f->head];
+    f->head = (f->head + 1) % f->capacity;
+    f->count--;
+    return packet;
+}
+
+static int event_before(const Event *a, const Event *b) {
+    return a->time != b->time ? a->time < b->time : a->order < b->order;
+}
+
+static void event_push(Sim *s, uint64_t time, int type, int id) {
+    if (s->event_count == s->event_capacity) {
+        s->event_capacity = s->event_capacity ? 2 * s->event_capacity : 64;
+        s->events = realloc(s->events, s->event_capacity * sizeof(Event));
+        if (!s->events) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    Event e = { time, s->next_order++, (uint16_t)type, (uint16_t)id };
+    uint32_t i = s->event_count++;
+    while (i > 0 && event_before(&e, &s->events[(i - 1) / 2])) {
+        s->events[i] = s->events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    s->events[i] = e;
+}
+
+static Event event_pop(Sim *s) {
+    Event top = s->events[0];
+    Event last = s->events[--s->event_count];
+    uint32_t i = 0;
+    while (2 * i + 1 < s->event_count) {
+        uint32_t child = 2 * i + 1;
+        if (child + 1 < s->event_count && event_before(&s->events[child + 1], &s->events[child])) {
+            child++;
+        }
+        if (!event_before(&s->events[child], &last)) {
+            break;
+        }
+        s->events[i] = s->events[child];
+        i = child;
+    }
+    s->events[i] = last;
+    return top;
+}
+
+// FNV-1a over one value
+static void digest_mix(Sim *s, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        s->digest = (s->digest ^ ((value >> (8 * i)) & 0xFF)) * 0x100000001B3ull;
+    }
+}
+
+#define TRACE_SIM(s, type, packet, arg)                                     \
+    do {                                                                    \
+        if ((s)->tracing) {                                                 \
+            TRACE_PACKET(&(s)->trace, (SimTick_t)(s)->now, type, packet, arg); \
+        }                                                                   \
+    } while (0)
+
+static void trace_out(void *context, const TraceEvent_t *e) {
+    Sim *s = context;
+    if (s->cfg.verbose) {
+        trace_print(stdout, e);
+    }
+    if (s->trace_file) {
+        fwrite(e, sizeof(*e), 1, s->trace_file);
+    }
+}
+
+// Receiver task: takes packets while it is idle, like ReceiverTask
+static void receiver_run(Sim *s, int r) {
+    Fifo *queue = &s->receiver_queues[r];
+    while (!s->receiver_busy[r] && !s->receiver_done[r] && queue->count > 0) {
+        Packet_t *packet = fifo_pop(queue);
+        ReceiverStats_t *stats = &s->receiver_stats[r];
+        if (packet->dest != RECEIVER_ADDRESS_BASE + r) {
+            TRACE_SIM(s, TRACE_WRONG_RECEIVER, packet, r);
+        } else if (stats->count < s->cfg.packets) {
+            uint32_t missing = receiver_accept(stats, packet);
+            if (missing) {
+                TRACE_SIM(s, TRACE_LOST, packet, missing);
+            }
+            TRACE_SIM(s, TRACE_RECEIVED, packet, 0);
+            digest_mix(s, s->now);
+            digest_mix(s, (uint64_t)r << 48 | (uint64_t)packet->sender_id << 32 | packet->seq_num);
+
+            if (stats->count >= s->cfg.packets) {
+                s->receiver_done[r] = 1; // Suspended: its queue fills up from here on
+                s->receivers_done++;
+            }
+        }
+        packet_free(&s->pools, packet);
+        if (s->cfg.receiver_ms > 0) {
+            s->receiver_busy[r] = 1;
+            event_push(s, s->now + s->cfg.receiver_ms, EV_RECEIVER, r);
+        }
+    }
+}
+
+// Sends a packet whose delay has elapsed to its output port, like switch_forward
+static void switch_forward(Sim *s, Packet_t *packet) {
+    uint16_t port = switch_route(&s->sw, packet);
+    if (port == PORT_NONE) {
+        TRACE_SIM(s, TRACE_INVALID_DEST, packet, 0);
+        s->sw.stats[packet->sender_id].invalid++;
+        packet_free(&s->pools, packet);
+        return;
+    }
+    TRACE_SIM(s, TRACE_FORWARDED, packet, 0);
+    int r = port - s->sw.senders;
+    Fifo *out = &s->receiver_queues[r];
+    if (!fifo_push(out, packet)) {
+        TRACE_SIM(s, TRACE_OVERFLOW, packet, 0);
+        s->sw.stats[port].overflow++;
+        packet_free(&s->pools, packet);
+        return;
+    }
+    port_count_tx(&s->sw.stats[port], packet, out->count);
+    receiver_run(s, r);
+}
+
+// vTaskDelayUntil: the next wake is one period after the last, or now if that has passed
+static void sender_schedule(Sim *s, int id) {
+    s->last_wake[id] += s->cfg.period_ms;
+    event_push(s, s->last_wake[id] > s->now ? s->last_wake[id] : s->now, EV_SENDER, id);
+}
+
+static void sender_enqueue(Sim *s, int id, Packet_t *packet) {
+    fifo_push(&s->sender_queues[id], packet);
+    s->input_set[(s->set_head + s->set_count++) % s->set_capacity] = (uint16_t)id;
+}
+
+// Switch task: forwards due packets and pulls new ones while the delay line has room,
+// like SwitchTask between two blocking calls
+static void switch_run(Sim *s) {
+    for (;;) {
+        while (s->delay_line.count > 0 && !tick_before((SimTick_t)s->now, s->delay_line.items[0].release)) {
+            switch_forward(s, delay_line_pop(&s->delay_line));
+        }
+        if (s->delay_line.count == s->delay_line.capacity || s->set_count == 0) {
+            return;
+        }
+
+        int id = s->input_set[s->set_head];
+        s->set_head = (s->set_head + 1) % s->set_capacity;
+        s->set_count--;
+        Packet_t *packet = fifo_pop(&s->sender_queues[id]);
+        PortStats_t *port = &s->sw.stats[id];
+        port_count_rx(port, packet, s->sender_queues[id].count);
+        if (s->blocked[id]) {
+            // The sender blocked on its full queue completes its send now
+            sender_enqueue(s, id, s->blocked[id]);
+            s->blocked[id] = NULL;
+            sender_schedule(s, id);
+        }
+
+        if (sim_chance(&s->switch_rng, s->cfg.drop)) {
+            TRACE_SIM(s, TRACE_DROPPED, packet, 0);
+            port->dropped++;
+            packet_free(&s->pools, packet);
+        } else {
+            delay_line_push(&s->delay_line, packet, (SimTick_t)(s->now + s->cfg.delay_ms));
+            event_push(s, s->now + s->cfg.delay_ms, EV_RELEASE, 0);
+        }
+    }
+}
+
+// Sender task: one period of SenderTask
+static void sender_wake(Sim *s, int id) {
+    Packet_t *packet = packet_alloc(&s->pools, !s->cfg.header_only);
+    if (!packet) {
+        if (s->tracing) {
+            TRACE(&s->trace, (SimTick_t)s->now, TRACE_POOL_EMPTY, id, 0, 0, 0);
+        }
+        s->pool_empty++;
+        sender_schedule(s, id);
+        return;
+    }
+    sender_make_packet(packet, id, &s->seq_nums[(size_t)id * s->sw.receivers], s->sw.receivers,
+                       &s->sender_rng[id]);
+    s->generated++;
+    TRACE_SIM(s, TRACE_GENERATED, packet, 0);
+
+    if (s->sender_queues[id].count == s->sender_queues[id].capacity) {
+        s->blocked[id] = packet; // xQueueSend with portMAX_DELAY: wait for the switch
+        return;
+    }
+    sender_enqueue(s, id, packet);
+    sender_schedule(s, id);
+    switch_run(s);
+}
+
+static int parse_args(int argc, char **argv, Config *cfg) {
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(arg, "--header-only")) {
+            cfg->header_only = 1;
+            continue;
+        }
+        if (!strcmp(arg, "--verbose")) {
+            cfg->verbose = 1;
+            continue;
+        }
+        if (!strcmp(arg, "--port-stats")) {
+            cfg->port_stats = 1;
+            continue;
+        }
+        if (!value) {
+            fprintf(stderr, "unknown or incomplete option %s\n", arg);
+            return 0;
+        }
+        if (!strcmp(arg, "--seed")) cfg->seed = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--packets")) cfg->packets = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--drop")) cfg->drop = atof(value);
+        else if (!strcmp(arg, "--delay")) cfg->delay_ms = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--period")) cfg->period_ms = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--queue")) cfg->queue_length = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--delay-line")) cfg->delay_line_length = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--receiver-ms")) cfg->receiver_ms = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--payload-blocks")) cfg->payload_blocks = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--until")) cfg->until_s = atof(value);
+        else if (!strcmp(arg, "--trace")) cfg->trace_path = value;
+        else if (!strcmp(arg, "--senders")) cfg->senders = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--receivers")) cfg->receivers = (uint32_t)strtoul(value, NULL, 0);
+        else if (!strcmp(arg, "--ports")) {
+            uint32_t ports = (uint32_t)strtoul(value, NULL, 0);
+            cfg->senders = ports / 2;
+            cfg->receivers = ports - ports / 2;
+        }
+        else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 0;
+        }
+        i++;
+    }
+    if (cfg->delay_line_length == 0) {
+        cfg->delay_line_length = 8 * (cfg->senders + cfg->receivers);
+    }
+    if (cfg->queue_length == 0 || cfg->period_ms == 0 || cfg->packets == 0 ||
+        cfg->drop < 0 || cfg->drop >= 1 || cfg->senders == 0 || cfg->receivers == 0) {
+        fprintf(stderr, "need --queue, --period, --packets, --senders, --receivers > 0 and 0 <= --drop < 1\n");
+        return 0;
+    }
+    // Pool blocks and port numbers are 16-bit, with 0xFFFF reserved
+    if (POOL_BLOCKS((uint64_t)cfg->senders, (uint64_t)cfg->receivers, (uint64_t)cfg->queue_length,
+                    (uint64_t)cfg->delay_line_length) >= POOL_NONE ||
+        cfg->senders + cfg->receivers >= PORT_NONE - RECEIVER_ADDRESS_BASE) {
+        fprintf(stderr, "ports, --queue and --delay-line need more than %u packets\n", POOL_NONE - 1);
+        return 0;
+    }
+    return 1;
+}
+
+// Post-run decoder: prints a file written by --trace
+static int decode_file(const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+    TraceEvent_t e;
+    uint64_t events = 0;
+    while (fread(&e, sizeof(e), 1, in) == 1) {
+        trace_print(stdout, &e);
+        events++;
+    }
+    fclose(in);
+    printf("Trace: %llu events\n", (unsigned long long)events);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && !strcmp(argv[1], "--decode")) {
+        return decode_file(argv[2]);
+    }
+    Config cfg = { 1, NUM_SENDERS, NUM_RECEIVERS, PACKETS_PER_RECEIVER, DROP_PROBABILITY, SWITCH_DELAY_MS,
+                   SENDER_PERIOD_MS, QUEUE_LENGTH, 0, 0, !SENDER_ATTACH_PAYLOAD, PAYLOAD_POOL_BLOCKS, 0, 0, NULL, 0 };
+    if (!parse_args(argc, argv, &cfg)) {
+        return 2;
+    }
+
+    Sim *s = xcalloc(1, sizeof(Sim));
+    s->cfg = cfg;
+    s->digest = 0xCBF29CE484222325ull;
+
+    const uint32_t senders = cfg.senders, receivers = cfg.receivers;
+    uint16_t blocks = (uint16_t)POOL_BLOCKS(senders, receivers, cfg.queue_length, cfg.delay_line_length);
+    s->pools.packets = xcalloc(blocks, sizeof(Packet_t));
+    uint16_t payload_blocks = cfg.header_only ? 0 : (uint16_t)payload_pool_blocks(cfg.payload_blocks, senders,
+                                                                                  receivers, cfg.queue_length, blocks);
+    s->pools.payloads = xcalloc(payload_blocks, PAYLOAD_SIZE);
+    pool_init(&s->pools.packet_pool, xcalloc(blocks, sizeof(uint16_t)), blocks);
+    pool_init(&s->pools.payload_pool, xcalloc(payload_blocks, sizeof(uint16_t)), payload_blocks);
+
+    switch_init(&s->sw, (uint16_t)senders, (uint16_t)receivers, xcalloc(SWITCH_ROUTES(receivers), sizeof(uint16_t)),
+                xaligned(senders + receivers, sizeof(PortStats_t)));
+    s->sender_queues = xcalloc(senders, sizeof(Fifo));
+    s->seq_nums = xcalloc((size_t)senders * receivers, sizeof(uint32_t));
+    s->sender_rng = xcalloc(senders, sizeof(SimRandom_t));
+    s->last_wake = xcalloc(senders, sizeof(uint64_t));
+    s->blocked = xcalloc(senders, sizeof(Packet_t *));
+    for (uint32_t i = 0; i < senders; i++) {
+        fifo_init(&s->sender_queues[i], cfg.queue_length);
+        sim_seed(&s->sender_rng[i], cfg.seed, STREAM_SENDER(i));
+        event_push(s, 0, EV_SENDER, i);
+    }
+    s->set_capacity = senders * cfg.queue_length;
+    s->input_set = xcalloc(s->set_capacity, sizeof(uint16_t));
+    sim_seed(&s->switch_rng, cfg.seed, STREAM_SWITCH);
+    delay_line_init(&s->delay_line, xcalloc(cfg.delay_line_length, sizeof(DelayedPacket_t)),
+                    cfg.delay_line_length);
+
+    s->receiver_queues = xcalloc(receivers, sizeof(Fifo));
+    s->receiver_stats = xcalloc(receivers, sizeof(ReceiverStats_t));
+    s->receiver_busy = xcalloc(receivers, 1);
+    s->receiver_done = xcalloc(receivers, 1);
+    for (uint32_t r = 0; r < receivers; r++) {
+        fifo_init(&s->receiver_queues[r], cfg.queue_length);
+        s->receiver_stats[r].last_seq = xcalloc(senders, sizeof(uint32_t));
+    }
+
+    s->tracing = cfg.verbose || cfg.trace_path;
+    if (s->tracing) {
+        // One ring is enough single-threaded. It is drained after every step, so it only
+        // has to hold what one step can record: a few events per packet in the switch.
+        uint32_t capacity = 64;
+        while (capacity < 4 * (cfg.delay_line_length + (senders + receivers) * cfg.queue_length) + 64) {
+            capacity *= 2;
+        }
+        trace_init(&s->trace, xcalloc(capacity, sizeof(TraceEvent_t)), capacity);
+    }
+    if (cfg.trace_path) {
+        s->trace_file = fopen(cfg.trace_path, "wb");
+        if (!s->trace_file) {
+            perror(cfg.trace_path);
+            return 1;
+        }
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const uint64_t until = (uint64_t)(cfg.until_s * 1000.0);
+    // Terminator: the run ends when every receiver has its packets
+    while (s->event_count > 0 && s->receivers_done < receivers) {
+        Event e = event_pop(s);
+        if (until && e.time > until) {
+            break;
+        }
+        s->now = e.time;
+        s->events_run++;
+        switch (e.type) {
+        case EV_SENDER: sender_wake(s, e.id); break;
+        case EV_RELEASE: switch_run(s); break;
+        case EV_RECEIVER:
+            s->receiver_busy[e.id] = 0;
+            receiver_run(s, e.id);
+            break;
+        }
+        if (s->tracing) {
+            trace_drain(&s->trace, 1, trace_out, s);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double wall = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("seed %u, %u senders, %u receivers, %u packets per receiver, drop %.4f, delay %u ms, "
+           "period %u ms, queue %u, delay line %u, receiver %u ms\n", cfg.seed, senders, receivers,
+           cfg.packets, cfg.drop, cfg.delay_ms, cfg.period_ms, cfg.queue_length, cfg.delay_line_length,
+           cfg.receiver_ms);
+    printf("%s after %.3f s virtual time\n",
+           s->receivers_done == receivers ? "Simulation complete" : "Stopped", s->now / 1000.0);
+    uint64_t received = 0, lost = 0;
+    for (uint32_t r = 0; r < receivers; r++) {
+        if (receivers <= 16) {
+            printf("Receiver %u: total %u, lost %u\n", r + 1, s->receiver_stats[r].count, s->receiver_stats[r].lost);
+        }
+        received += s->receiver_stats[r].count;
+        lost += s->receiver_stats[r].lost;
+    }
+    printf("Receivers: total %llu, lost %llu\n", (unsigned long long)received, (unsigned long long)lost);
+    printf("Senders: generated %llu, pool empty %llu\n",
+           (unsigned long long)s->generated, (unsigned long long)s->pool_empty);
+    switch_print_stats(&s->sw, s->now, cfg.port_stats);
+    pool_print_stats("Packet", &s->pools.packet_pool);
+    pool_print_stats("Payload", &s->pools.payload_pool);
+    printf("Events: %llu in %.3f s wall, %.0f events/s\n", (unsigned long long)s->events_run, wall,
+           wall > 0 ? s->events_run / wall : 0.0);
+    if (s->tracing && s->trace.overruns) {
+        printf("Trace: %u events lost to a full ring\n", (unsigned)s->trace.overruns);
+    }
+    if (s->trace_file) {
+        fclose(s->trace_file);
+    }
+    printf("Digest: %016llx\n", (unsigned long long)s->digest);
+    return 0;
+}
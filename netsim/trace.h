@@ -0,0 +1,188 @@
+// Binary packet trace for the network simulation, shared by main.c and netsim_host.c.
+// Tasks record fixed-size events into their own ring instead of calling printf for every
+// packet; a low-priority task or a post-run tool decodes them into the usual log lines.
+// Recording an event is a few stores and no formatting or I/O, so full per-packet traces
+// do not change the timing being simulated.
+#ifndef NETSIM_TRACE_H
+#define NETSIM_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "netsim.h"
+
+// Log levels. Events above TRACE_LEVEL are compiled out, arguments and timestamp included.
+#define TRACE_NONE 0                // No trace
+#define TRACE_ERRORS 1              // Pool exhaustion, failed sends, misrouted packets
+#define TRACE_LOSSES 2              // Plus packets dropped, overflowed or found missing
+#define TRACE_PACKETS 3             // Plus every packet generated, forwarded and received
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_PACKETS
+#endif
+
+#define TRACE_RING_LENGTH 128       // Events per task ring, a power of two
+#define TRACE_DRAIN_MS 20           // How often the FreeRTOS trace task decodes the rings
+
+// Event types; the high nibble is the level the event belongs to
+enum {
+    TRACE_POOL_EMPTY = 0x10,        // Sender found the packet pool empty
+    TRACE_SEND_FAILED,              // Sender could not queue a packet
+    TRACE_INVALID_DEST,             // Switch had no route for the destination
+    TRACE_WRONG_RECEIVER,           // Receiver got another receiver's packet (arg: receiver index)
+    TRACE_DROPPED = 0x20,           // Switch dropped a packet on purpose
+    TRACE_OVERFLOW,                 // Switch found the output queue full
+    TRACE_LOST,                     // Receiver found a sequence gap (arg: packets missing)
+    TRACE_GENERATED = 0x30,         // Sender queued a new packet
+    TRACE_FORWARDED,                // Switch sent a packet to its output port
+    TRACE_RECEIVED,                 // Receiver accepted a packet
+};
+
+#define TRACE_ENABLED(type) (((type) >> 4) <= TRACE_LEVEL)
+
+// One trace event, 16 bytes
+typedef struct {
+    SimTick_t time;                 // Tick (millisecond) the event happened at
+    uint32_t seq;                   // Packet sequence number
+    uint16_t sender;                // Sender index
+    uint16_t dest;                  // Destination address
+    uint16_t arg;                   // Event-specific value, see the event types
+    uint8_t type;                   // TRACE_* event type
+    uint8_t reserved;
+} TraceEvent_t;
+
+// Single-producer, single-consumer ring: one task writes, the decoder reads. head and tail
+// count events forever and wrap at 2^32; the index is the count masked by the capacity.
+// A full ring drops the new event and counts it rather than making the task wait.
+typedef struct {
+    TraceEvent_t *events;           // Storage, capacity entries
+    uint32_t mask;                  // Capacity - 1
+    volatile uint32_t head;         // Events written, only the producer changes it
+    volatile uint32_t tail;         // Events read, only the consumer changes it
+    volatile uint32_t overruns;     // Events dropped because the ring was full
+} TraceRing_t;
+
+// capacity must be a power of two
+static inline void trace_init(TraceRing_t *ring, TraceEvent_t *events, uint32_t capacity) {
+    ring->events = events;
+    ring->mask = capacity - 1;
+    ring->head = ring->tail = ring->overruns = 0;
+}
+
+static inline void trace_put(TraceRing_t *ring, SimTick_t time, uint8_t type, uint16_t sender,
+                             uint16_t dest, uint32_t seq, uint32_t arg) {
+    uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > ring->mask) {
+        ring->overruns++;
+        return;
+    }
+    TraceEvent_t *e = &ring->events[head & ring->mask];
+    e->time = time;
+    e->seq = seq;
+    e->sender = sender;
+    e->dest = dest;
+    e->arg = arg > 0xFFFF ? 0xFFFF : (uint16_t)arg;
+    e->type = type;
+    e->reserved = 0;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Oldest unread event, NULL if the ring is empty; trace_next releases it
+static inline const TraceEvent_t *trace_peek(TraceRing_t *ring) {
+    uint32_t tail = ring->tail;
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    return &ring->events[tail & ring->mask];
+}
+
+static inline void trace_next(TraceRing_t *ring) {
+    __atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+// Records an event if its level is compiled in; time is only evaluated then
+#define TRACE(ring, time, type, sender, dest, seq, arg)                         \
+    do {                                                                        \
+        if (TRACE_ENABLED(type)) {                                              \
+            trace_put((ring), (time), (type), (sender), (dest), (seq), (arg));  \
+        }                                                                       \
+    } while (0)
+
+#define TRACE_PACKET(ring, time, type, packet, arg) \
+    TRACE(ring, time, type, (packet)->sender_id, (packet)->dest, (packet)->seq_num, arg)
+
+// Prints one event as the log line the task used to print, after its time in seconds
+static inline void trace_print(FILE *out, const TraceEvent_t *e) {
+    int sender = e->sender + 1, dest = e->dest - 2; // Displayed numbers, as in the logs
+    fprintf(out, "%10.3f ", e->time / 1000.0);
+    switch (e->type) {
+    case TRACE_POOL_EMPTY:
+        fprintf(out, "Sender %d: Packet pool empty\n", sender);
+        break;
+    case TRACE_SEND_FAILED:
+        fprintf(out, "Sender %d: Queue send failed\n", sender);
+        break;
+    case TRACE_INVALID_DEST:
+        fprintf(out, "Switch: Invalid dest %d from sender %d for seq %u\n", dest, sender, (unsigned)e->seq);
+        break;
+    case TRACE_WRONG_RECEIVER:
+        fprintf(out, "Receiver %d: Error - received packet for dest %d from sender %d, seq %u\n",
+                e->arg + 1, dest, sender, (unsigned)e->seq);
+        break;
+    case TRACE_DROPPED:
+        fprintf(out, "Switch: Dropped packet from sender %d for dest %d, seq %u\n", sender, dest, (unsigned)e->seq);
+        break;
+    case TRACE_OVERFLOW:
+        fprintf(out, "Switch: Output queue full, dropped packet from sender %d for dest %d, seq %u\n",
+                sender, dest, (unsigned)e->seq);
+        break;
+    case TRACE_LOST:
+        fprintf(out, "Receiver %d: Detected %u lost packets from sender %d\n", dest, (unsigned)e->arg, sender);
+        break;
+    case TRACE_GENERATED:
+        fprintf(out, "Sender %d: Generated packet for dest %d, seq %u\n", sender, dest, (unsigned)e->seq);
+        break;
+    case TRACE_FORWARDED:
+        fprintf(out, "Switch: Forwarding packet from sender %d to dest %d, seq %u\n", sender, dest, (unsigned)e->seq);
+        break;
+    case TRACE_RECEIVED:
+        fprintf(out, "Receiver %d: Received packet from sender %d, seq %u\n", dest, sender, (unsigned)e->seq);
+        break;
+    default:
+        fprintf(out, "Unknown trace event %u\n", (unsigned)e->type);
+        break;
+    }
+}
+
+// Decodes every event waiting in the rings, oldest first across rings (ties in ring
+// order), and passes each to print. Returns the number of events decoded.
+static inline uint32_t trace_drain(TraceRing_t *rings, uint32_t count,
+                                   void (*print)(void *context, const TraceEvent_t *e), void *context) {
+    uint32_t decoded = 0;
+    for (;;) {
+        TraceRing_t *oldest = NULL;
+        const TraceEvent_t *first = NULL;
+        for (uint32_t i = 0; i < count; i++) {
+            const TraceEvent_t *e = trace_peek(&rings[i]);
+            if (e && (!first || tick_before(e->time, first->time))) {
+                oldest = &rings[i];
+                first = e;
+            }
+        }
+        if (!first) {
+            return decoded;
+        }
+        print(context, first);
+        trace_next(oldest);
+        decoded++;
+    }
+}
+
+// Events dropped across all rings because a ring was full
+static inline uint32_t trace_overruns(const TraceRing_t *rings, uint32_t count) {
+    uint32_t overruns = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        overruns += rings[i].overruns;
+    }
+    return overruns;
+}
+
+#endif // NETSIM_TRACE_H
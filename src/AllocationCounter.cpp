@@ -0,0 +1,38 @@
+#include "../include/AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Constant-initialized, so reading them needs no guard
+thread_local int openCounters = 0;
+thread_local uint64_t counted = 0;
+
+} // namespace
+
+AllocationCounter::AllocationCounter() : start(counted) {
+    ++openCounters;
+}
+
+AllocationCounter::~AllocationCounter() {
+    --openCounters;
+}
+
+uint64_t AllocationCounter::count() const {
+    return counted - start;
+}
+
+// new[] and the nothrow forms forward here, so this catches them too
+void* operator new(std::size_t size) {
+    if (openCounters) ++counted;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,255 @@
+#include "../include/AsyncAI.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+bool sameStones(const Board& a, const Board& b) {
+    return a.size() == b.size() && a.winLength() == b.winLength() &&
+           std::memcmp(&a.bits('X'), &b.bits('X'), sizeof(BoardMask)) == 0 &&
+           std::memcmp(&a.bits('O'), &b.bits('O'), sizeof(BoardMask)) == 0;
+}
+
+// Puts the stones of board on target's fresh game, X and O alternating
+void replay(Game& target, const Board& board) {
+    target.reset();
+    int xs[MAX_CELLS], os[MAX_CELLS];
+    int nx = 0, no = 0;
+    for (int c = 0; c < board.cellCount(); ++c) {
+        if (board.at(c) == 'X') xs[nx++] = c;
+        else if (board.at(c) == 'O') os[no++] = c;
+    }
+    const int n = board.size();
+    for (int i = 0; i < nx || i < no; ++i) {
+        if (i < nx) {
+            target.makeMove(xs[i] / n, xs[i] % n);
+            target.switchPlayer();
+        }
+        if (i < no) {
+            target.makeMove(os[i] / n, os[i] % n);
+            target.switchPlayer();
+        }
+    }
+}
+
+// Likely replies first: empty cells closest to a stone, then to the centre
+int orderReplies(const Board& board, int* cells) {
+    const int n = board.size();
+    std::pair<int, int> keyed[MAX_CELLS];
+    int count = 0;
+    for (int c = 0; c < board.cellCount(); ++c) {
+        if (!board.isEmpty(c)) continue;
+        int nearest = board.moveCount() ? n : 0;
+        for (int s = 0; s < board.cellCount(); ++s)
+            if (!board.isEmpty(s))
+                nearest = std::min(nearest, std::max(std::abs(s / n - c / n), std::abs(s % n - c % n)));
+        int fromCentre = std::abs(2 * (c / n) - (n - 1)) + std::abs(2 * (c % n) - (n - 1));
+        keyed[count++] = {nearest * 4 * n + fromCentre, c};
+    }
+    std::stable_sort(keyed, keyed + count,
+                     [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; });
+    for (int i = 0; i < count; ++i) cells[i] = keyed[i].second;
+    return count;
+}
+
+} // namespace
+
+AsyncAI::AsyncAI(Game& game) : game(game) {
+    std::fill(answers, answers + MAX_CELLS, -1);
+    worker = std::thread(&AsyncAI::workerLoop, this);
+}
+
+AsyncAI::~AsyncAI() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+        stopSearch = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void AsyncAI::startPondering() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (task == Task::Move || task == Task::JoinPonder) return; // the AI is still moving
+    const Board& now = game.getBoard();
+    if (task == Task::Ponder && sameStones(now, snapshot)) return;
+
+    ++generation;
+    if (current >= 0) stopSearch = true; // stale: it answers a different position
+    snapshot = now;
+    mode = game.getAIMode();
+    searchLimits = game.getSearchLimits();
+    mctsLimits = game.getMctsLimits();
+    telemetry = game.getTelemetry();
+    candidateCount = orderReplies(snapshot, candidates);
+    nextCandidate = 0;
+    std::fill(answers, answers + MAX_CELLS, -1);
+    task = Task::Ponder;
+    wake.notify_all();
+}
+
+void AsyncAI::stopPondering() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (task != Task::Ponder) return;
+    ++generation;
+    if (current >= 0) stopSearch = true;
+    task = Task::Idle;
+}
+
+bool AsyncAI::followsSnapshot(int reply) const {
+    const Board& now = game.getBoard();
+    if (reply < 0 || now.moveCount() != snapshot.moveCount() + 1) return false;
+    Board before = now;
+    before.remove(reply);
+    return sameStones(before, snapshot);
+}
+
+std::future<int> AsyncAI::requestMove() {
+    std::lock_guard<std::mutex> guard(lock);
+    pending = std::promise<int>();
+    std::future<int> result = pending.get_future();
+    cancelRequested = false;
+
+    const int reply = game.getLastMove();
+    const bool pondered = task == Task::Ponder && followsSnapshot(reply);
+    if (pondered && answers[reply] >= 0) {
+        ++counters.hits;
+        ++generation;
+        if (current >= 0) stopSearch = true;
+        task = Task::Idle;
+        const int cell = answers[reply];
+        game.makeMove(cell / game.getSize(), cell % game.getSize());
+        if (telemetry) {
+            MoveStats move = answerStats[reply];
+            move.pondered = true;
+            telemetry->recordMove(answerBackends[reply], move);
+        }
+        pending.set_value(cell);
+        return result;
+    }
+    if (pondered && current == reply) {
+        ++counters.joined;
+        task = Task::JoinPonder; // the worker plays it when the search ends
+    } else {
+        if (task == Task::Ponder) ++counters.misses;
+        ++generation;
+        if (current >= 0) stopSearch = true;
+        task = Task::Move;
+    }
+    wake.notify_all();
+    return result;
+}
+
+void AsyncAI::cancel() {
+    std::lock_guard<std::mutex> guard(lock);
+    cancelRequested = true;
+    if (task == Task::Move || task == Task::JoinPonder) stopSearch = true;
+}
+
+PonderStats AsyncAI::stats() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return counters;
+}
+
+void AsyncAI::workerLoop() {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+        wake.wait(guard, [&] {
+            return quit || task == Task::Move || (task == Task::Ponder && nextCandidate < candidateCount);
+        });
+        if (quit) return;
+        if (task == Task::Move) runMove(guard);
+        else ponderReply(guard);
+    }
+}
+
+// The game is ours until the promise is set
+void AsyncAI::runMove(std::unique_lock<std::mutex>& guard) {
+    stopSearch = cancelRequested;
+    guard.unlock();
+
+    const SearchLimits savedSearch = game.getSearchLimits();
+    const MctsLimits savedMcts = game.getMctsLimits();
+    SearchLimits l = savedSearch;
+    l.stop = &stopSearch;
+    MctsLimits m = savedMcts;
+    m.stop = &stopSearch;
+    game.setSearchLimits(l);
+    game.setMctsLimits(m);
+
+    const int before = game.getBoard().moveCount();
+    game.makeAIMoveWithTree();
+    const int cell = game.getBoard().moveCount() > before ? game.getLastMove() : -1;
+    game.setSearchLimits(savedSearch);
+    game.setMctsLimits(savedMcts);
+
+    guard.lock();
+    task = Task::Idle;
+    pending.set_value(cell);
+}
+
+// Searches the AI's answer to the next likely reply on the shadow game
+void AsyncAI::ponderReply(std::unique_lock<std::mutex>& guard) {
+    const int reply = candidates[nextCandidate++];
+    const uint64_t gen = generation;
+    const Board base = snapshot;
+    SearchLimits l = searchLimits;
+    l.stop = &stopSearch;
+    MctsLimits m = mctsLimits;
+    m.stop = &stopSearch;
+    Telemetry* const sink = telemetry;
+    current = reply;
+    stopSearch = false;
+    guard.unlock();
+
+    if (!shadow || shadow->getSize() != base.size() || shadow->getWinLength() != base.winLength())
+        shadow.reset(new Game(base.size(), base.winLength()));
+    shadow->setAIMode(mode);
+    shadow->setSearchLimits(l);
+    shadow->setMctsLimits(m);
+    replay(*shadow, base);
+
+    int answer = -1;
+    AIMode backend = mode;
+    MoveStats stats;
+    const int n = base.size();
+    shadow->makeMove(reply / n, reply % n);
+    if (!shadow->checkWin() && !shadow->checkDraw()) {
+        shadow->switchPlayer();
+        if (sink) {
+            backend = shadow->measureAIMove(stats);
+            sink->recordPonder(backend, stats);
+        } else {
+            shadow->makeAIMoveWithTree();
+        }
+        if (shadow->getLastMove() != reply) answer = shadow->getLastMove();
+    }
+
+    guard.lock();
+    current = -1;
+    if (task == Task::JoinPonder) {
+        // The human played this reply while it was being searched. A cancel
+        // stopped the search early; its best move so far is still played.
+        if (answer >= 0) {
+            game.makeMove(answer / n, answer % n);
+            if (sink) {
+                stats.pondered = true;
+                sink->recordMove(backend, stats);
+            }
+            task = Task::Idle;
+            pending.set_value(answer);
+        } else {
+            task = Task::Move;
+        }
+        return;
+    }
+    if (gen == generation && !stopSearch && answer >= 0) {
+        answers[reply] = answer;
+        answerBackends[reply] = backend;
+        answerStats[reply] = stats;
+        ++counters.pondered;
+    }
+}
@@ -0,0 +1,149 @@
+#include "../include/BatchEval.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Every kernel writes one byte per board: the evaluateBits value when
+// Classify is false, the GameResult otherwise
+template <bool Classify>
+void scalarKernel(const uint16_t* x, const uint16_t* o, size_t begin, size_t count, uint8_t* out) {
+    for (size_t i = begin; i < count; ++i) {
+        bool oLine = hasLine(o[i]);
+        bool xLine = hasLine(x[i]);
+        if (Classify) {
+            GameResult r = oLine ? GameResult::OWins
+                         : xLine ? GameResult::XWins
+                         : (x[i] | o[i]) == FULL_BOARD ? GameResult::Draw
+                         : GameResult::Unfinished;
+            out[i] = uint8_t(r);
+        } else {
+            out[i] = uint8_t(int8_t(oLine ? 1 : (xLine ? -1 : 0)));
+        }
+    }
+}
+
+#ifdef BATCH_X86
+
+// Lanes are 16-bit boards. A lane is all ones where a mask is fully covered,
+// so OR-ing the eight comparisons gives a per-board "has a line" flag.
+template <bool Classify>
+__attribute__((target("sse2")))
+void sse2Kernel(const uint16_t* x, const uint16_t* o, size_t count, uint8_t* out) {
+    const __m128i full = _mm_set1_epi16(FULL_BOARD);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i vx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        __m128i vo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(o + i));
+        __m128i xLine = _mm_setzero_si128(), oLine = _mm_setzero_si128();
+        for (uint16_t mask : WIN_MASKS) {
+            __m128i m = _mm_set1_epi16(short(mask));
+            xLine = _mm_or_si128(xLine, _mm_cmpeq_epi16(_mm_and_si128(vx, m), m));
+            oLine = _mm_or_si128(oLine, _mm_cmpeq_epi16(_mm_and_si128(vo, m), m));
+        }
+
+        __m128i r;
+        if (Classify) {
+            __m128i isFull = _mm_cmpeq_epi16(_mm_or_si128(vx, vo), full);
+            __m128i rest = _mm_or_si128(_mm_and_si128(xLine, _mm_set1_epi16(1)),
+                                        _mm_andnot_si128(xLine, _mm_and_si128(isFull, _mm_set1_epi16(3))));
+            r = _mm_or_si128(_mm_and_si128(oLine, _mm_set1_epi16(2)), _mm_andnot_si128(oLine, rest));
+        } else {
+            // X's flag is already -1 per lane
+            r = _mm_or_si128(_mm_and_si128(oLine, _mm_set1_epi16(1)), _mm_andnot_si128(oLine, xLine));
+        }
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi16(r, r));
+    }
+    scalarKernel<Classify>(x, o, i, count, out);
+}
+
+template <bool Classify>
+__attribute__((target("avx2")))
+void avx2Kernel(const uint16_t* x, const uint16_t* o, size_t count, uint8_t* out) {
+    const __m256i full = _mm256_set1_epi16(FULL_BOARD);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+        __m256i vo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(o + i));
+        __m256i xLine = _mm256_setzero_si256(), oLine = _mm256_setzero_si256();
+        for (uint16_t mask : WIN_MASKS) {
+            __m256i m = _mm256_set1_epi16(short(mask));
+            xLine = _mm256_or_si256(xLine, _mm256_cmpeq_epi16(_mm256_and_si256(vx, m), m));
+            oLine = _mm256_or_si256(oLine, _mm256_cmpeq_epi16(_mm256_and_si256(vo, m), m));
+        }
+
+        __m256i r;
+        if (Classify) {
+            __m256i isFull = _mm256_cmpeq_epi16(_mm256_or_si256(vx, vo), full);
+            __m256i rest = _mm256_or_si256(_mm256_and_si256(xLine, _mm256_set1_epi16(1)),
+                                           _mm256_andnot_si256(xLine, _mm256_and_si256(isFull, _mm256_set1_epi16(3))));
+            r = _mm256_or_si256(_mm256_and_si256(oLine, _mm256_set1_epi16(2)), _mm256_andnot_si256(oLine, rest));
+        } else {
+            r = _mm256_or_si256(_mm256_and_si256(oLine, _mm256_set1_epi16(1)), _mm256_andnot_si256(oLine, xLine));
+        }
+        // packs works per 128-bit half; gather the two low quadwords
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(r, r), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    scalarKernel<Classify>(x, o, i, count, out);
+}
+
+#endif // BATCH_X86
+
+BatchKernel resolve(BatchKernel kernel) {
+    if (kernel == BatchKernel::Auto || !batchKernelSupported(kernel)) return bestBatchKernel();
+    return kernel;
+}
+
+template <bool Classify>
+void run(const uint16_t* x, const uint16_t* o, size_t count, uint8_t* out, BatchKernel kernel) {
+    switch (resolve(kernel)) {
+#ifdef BATCH_X86
+    case BatchKernel::Avx2: avx2Kernel<Classify>(x, o, count, out); return;
+    case BatchKernel::Sse2: sse2Kernel<Classify>(x, o, count, out); return;
+#endif
+    default: scalarKernel<Classify>(x, o, 0, count, out); return;
+    }
+}
+
+} // namespace
+
+bool batchKernelSupported(BatchKernel kernel) {
+    switch (kernel) {
+    case BatchKernel::Auto:
+    case BatchKernel::Scalar: return true;
+#ifdef BATCH_X86
+    case BatchKernel::Sse2: return __builtin_cpu_supports("sse2");
+    case BatchKernel::Avx2: return __builtin_cpu_supports("avx2");
+#endif
+    default: return false;
+    }
+}
+
+BatchKernel bestBatchKernel() {
+    static const BatchKernel best = batchKernelSupported(BatchKernel::Avx2) ? BatchKernel::Avx2
+                                  : batchKernelSupported(BatchKernel::Sse2) ? BatchKernel::Sse2
+                                  : BatchKernel::Scalar;
+    return best;
+}
+
+const char* batchKernelName(BatchKernel kernel) {
+    switch (kernel) {
+    case BatchKernel::Auto: return batchKernelName(bestBatchKernel());
+    case BatchKernel::Scalar: return "scalar";
+    case BatchKernel::Sse2: return "sse2";
+    case BatchKernel::Avx2: return "avx2";
+    }
+    return "?";
+}
+
+void evaluateBatch(const uint16_t* x, const uint16_t* o, size_t count, int8_t* out, BatchKernel kernel) {
+    run<false>(x, o, count, reinterpret_cast<uint8_t*>(out), kernel);
+}
+
+void classifyBatch(const uint16_t* x, const uint16_t* o, size_t count, GameResult* out, BatchKernel kernel) {
+    run<true>(x, o, count, reinterpret_cast<uint8_t*>(out), kernel);
+}
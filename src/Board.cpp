@@ -0,0 +1,144 @@
+#include "../include/Board.h"
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+std::unique_ptr<BoardGeometry> makeGeometry(int size, int winLength) {
+    auto g = std::make_unique<BoardGeometry>();
+    g->size = size;
+    g->winLength = winLength;
+    g->cells = size * size;
+
+    std::vector<std::vector<uint16_t>> byCell(g->cells);
+    g->windowCount = forEachWindowCell(size, winLength, [&](int window, int cell) {
+        byCell[cell].push_back(static_cast<uint16_t>(window));
+    });
+    for (int c = 0; c < g->cells; ++c) {
+        g->cellWindowStart[c] = static_cast<uint16_t>(g->cellWindows.size());
+        g->cellWindows.insert(g->cellWindows.end(), byCell[c].begin(), byCell[c].end());
+    }
+    g->cellWindowStart[g->cells] = static_cast<uint16_t>(g->cellWindows.size());
+
+    for (int s = 0; s < 8; ++s) {
+        for (int c = 0; c < g->cells; ++c) {
+            int image = symmetricCell(size, s, c);
+            g->symmetry[s][c] = static_cast<uint8_t>(image);
+            g->inverse[s][image] = static_cast<uint8_t>(c);
+        }
+    }
+
+    g->cellMask = BoardMask{};
+    for (int c = 0; c < g->cells; ++c) {
+        g->cellMask.set(c);
+        g->nearMask[c] = BoardMask{};
+        forEachNearCell(size, c, [&](int near) { g->nearMask[c].set(near); });
+    }
+    return g;
+}
+
+} // namespace
+
+const BoardGeometry& BoardGeometry::get(int size, int winLength) {
+    if (size < 1 || size > MAX_BOARD_SIZE || winLength < 1 || winLength > size)
+        throw std::invalid_argument("unsupported board size or win length");
+
+    static std::mutex lock;
+    static std::map<std::pair<int, int>, std::unique_ptr<BoardGeometry>> cache;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto& slot = cache[{size, winLength}];
+    if (!slot) slot = makeGeometry(size, winLength);
+    return *slot;
+}
+
+Board::Board(int size, int winLength)
+    : geo(&BoardGeometry::get(size, winLength)), x{}, o{}, hashes{}, moves(0),
+      lineCount{}, completed{} {}
+
+Board& Board::operator=(const Board& other) {
+    geo = other.geo;
+    x = other.x;
+    o = other.o;
+    std::memcpy(hashes, other.hashes, sizeof(hashes));
+    moves = other.moves;
+    std::memcpy(lineCount[0], other.lineCount[0], geo->windowCount);
+    std::memcpy(lineCount[1], other.lineCount[1], geo->windowCount);
+    completed[0] = other.completed[0];
+    completed[1] = other.completed[1];
+    return *this;
+}
+
+BoardMask Board::empties() const {
+    BoardMask m = geo->cellMask;
+    for (int i = 0; i < BOARD_WORDS; ++i) m.w[i] &= ~(x.w[i] | o.w[i]);
+    return m;
+}
+
+char Board::at(int cell) const {
+    if (x.test(cell)) return 'X';
+    if (o.test(cell)) return 'O';
+    return ' ';
+}
+
+void Board::place(int cell, char player) {
+    int p = (player == 'X') ? 0 : 1;
+    (p == 0 ? x : o).set(cell);
+    for (int s = 0; s < 8; ++s)
+        hashes[s] ^= ZOBRIST.keys[p][geo->symmetry[s][cell]];
+    ++moves;
+
+    const int k = geo->winLength;
+    for (int i = geo->cellWindowStart[cell]; i < geo->cellWindowStart[cell + 1]; ++i)
+        if (++lineCount[p][geo->cellWindows[i]] == k) ++completed[p];
+}
+
+void Board::remove(int cell) {
+    int p;
+    if (x.test(cell)) p = 0;
+    else if (o.test(cell)) p = 1;
+    else return;
+
+    (p == 0 ? x : o).reset(cell);
+    for (int s = 0; s < 8; ++s)
+        hashes[s] ^= ZOBRIST.keys[p][geo->symmetry[s][cell]];
+    --moves;
+
+    const int k = geo->winLength;
+    for (int i = geo->cellWindowStart[cell]; i < geo->cellWindowStart[cell + 1]; ++i)
+        if (lineCount[p][geo->cellWindows[i]]-- == k) --completed[p];
+}
+
+void Board::clear() {
+    x = BoardMask{};
+    o = BoardMask{};
+    for (uint64_t& h : hashes) h = 0;
+    moves = 0;
+    std::memset(lineCount[0], 0, geo->windowCount);
+    std::memset(lineCount[1], 0, geo->windowCount);
+    completed[0] = completed[1] = 0;
+}
+
+// Only the windows through cell can have been completed by its stone
+bool Board::isWinningMove(int cell) const {
+    int p;
+    if (x.test(cell)) p = 0;
+    else if (o.test(cell)) p = 1;
+    else return false;
+
+    const int k = geo->winLength;
+    for (int i = geo->cellWindowStart[cell]; i < geo->cellWindowStart[cell + 1]; ++i)
+        if (lineCount[p][geo->cellWindows[i]] == k) return true;
+    return false;
+}
+
+int Board::canonicalSymmetry() const {
+    int best = 0;
+    for (int s = 1; s < 8; ++s)
+        if (hashes[s] < hashes[best]) best = s;
+    return best;
+}
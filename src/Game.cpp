@@ -1,63 +1,87 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include "AllocationCounter.h"
 #include "Game.h"
+#include "SolvedTable.h"
+#include "Symmetry.h"
+#include "Telemetry.h"
 
-Game::Game() {
-    board = std::vector<std::vector<char>>(3, std::vector<char>(3, ' '));
+// The 3x3 board packed into the layout used by the solved table
+static Bitboard toBitboard(const Board& b) {
+    return Bitboard(static_cast<uint16_t>(b.bits('X').w[0]), static_cast<uint16_t>(b.bits('O').w[0]));
+}
+
+Game::Game(int size, int winLength) : board(size, winLength) {
+    currentPlayer = 'X';
+}
+
+void Game::reset() {
+    board.clear();
     currentPlayer = 'X';
+    tree.rewind(); // a tree built from the empty board serves every game
 }
 
 void Game::displayBoard() {
+    const int n = board.size();
     std::cout << "\n";
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < n; i++) {
         std::cout << " ";
-        for (int j = 0; j < 3; j++) {
-            std::cout << board[i][j];
-            if (j < 2) std::cout << " | ";
+        for (int j = 0; j < n; j++) {
+            std::cout << board.at(i * n + j);
+            if (j < n - 1) std::cout << " | ";
         }
         std::cout << "\n";
-        if (i < 2) std::cout << "---+---+---\n";
+        if (i < n - 1) {
+            for (int j = 0; j < n; j++) std::cout << (j ? "+---" : "---");
+            std::cout << "\n";
+        }
     }
     std::cout << "\n";
 }
 
 bool Game::makeMove(int row, int col) {
-    if (row < 0 || row > 2 || col < 0 || col > 2) return false;
-    if (board[row][col] != ' ') return false;
+    const int n = board.size();
+    if (row < 0 || row >= n || col < 0 || col >= n) return false;
+    if (!board.isEmpty(row * n + col)) return false;
 
-    board[row][col] = currentPlayer;
+    playCell(row * n + col);
     return true;
 }
 
-bool Game::checkWin() {
-    for (int i = 0; i < 3; i++) {
-        // rows and columns
-        if ((board[i][0] == currentPlayer &&
-             board[i][1] == currentPlayer &&
-             board[i][2] == currentPlayer) ||
-            (board[0][i] == currentPlayer &&
-             board[1][i] == currentPlayer &&
-             board[2][i] == currentPlayer))
-            return true;
-    }
-    // diagonals
-    if ((board[0][0] == currentPlayer &&
-         board[1][1] == currentPlayer &&
-         board[2][2] == currentPlayer) ||
-        (board[0][2] == currentPlayer &&
-         board[1][1] == currentPlayer &&
-         board[2][0] == currentPlayer))
-        return true;
+// Every move, human or AI, goes through here so the arena tree follows it
+void Game::playCell(int cell) {
+    history[board.moveCount()] = static_cast<uint8_t>(cell);
+    board.place(cell, currentPlayer);
+    tree.advance(cell); // keep the subtree for the reply, if there is one
 
-    return false;
+    if (!recorder) return;
+    GameResult result = GameResult::Unfinished;
+    if (board.hasWon(currentPlayer)) result = currentPlayer == 'X' ? GameResult::XWins : GameResult::OWins;
+    else if (board.isFull()) result = GameResult::Draw;
+    if (result != GameResult::Unfinished)
+        recorder->write(board.size(), board.winLength(), recordX, recordO, history, board.moveCount(), result);
+}
+
+bool Game::undoMove() {
+    if (board.moveCount() == 0) return false;
+
+    int cell = history[board.moveCount() - 1];
+    currentPlayer = board.at(cell);
+    board.remove(cell);
+    tree.rewind(); // makeTreeMove walks back down to the live position
+    return true;
+}
+
+// Both checks read counters that makeMove keeps up to date, so they cost the
+// same on a 15x15 board as on 3x3
+bool Game::checkWin() {
+    return board.hasWon(currentPlayer);
 }
 
 bool Game::checkDraw() {
-    for (auto& row : board) {
-        for (auto& cell : row) {
-            if (cell == ' ') return false;
-        }
-    }
-    return !checkWin(); // draw only if there's no winner
+    if (!board.isFull()) return false;
+    return !board.hasWon('X') && !board.hasWon('O'); // draw only if there's no winner
 }
 
 void Game::switchPlayer() {
@@ -68,91 +92,180 @@ char Game::getCurrentPlayer() {
     return currentPlayer;
 }
 int Game::evaluateBoard(char b[3][3]) {
-    // Check rows, columns and diagonals for win
-    for (int i = 0; i < 3; ++i) {
-        if (b[i][0] == b[i][1] && b[i][1] == b[i][2] && b[i][0] != ' ')
-            return (b[i][0] == 'O') ? 1 : -1;
-        if (b[0][i] == b[1][i] && b[1][i] == b[2][i] && b[0][i] != ' ')
-            return (b[0][i] == 'O') ? 1 : -1;
-    }
-    if (b[0][0] == b[1][1] && b[1][1] == b[2][2] && b[0][0] != ' ')
-        return (b[0][0] == 'O') ? 1 : -1;
-    if (b[0][2] == b[1][1] && b[1][1] == b[2][0] && b[0][2] != ' ')
-        return (b[0][2] == 'O') ? 1 : -1;
-    return 0;
+    return evaluateBits(toBitboard(b));
 }
 
-bool isDraw(char b[3][3]) {
-    for (int i = 0; i < 3; ++i)
-        for (int j = 0; j < 3; ++j)
-            if (b[i][j] == ' ') return false;
-    return true;
+int Game::evaluateBoard(const Bitboard& b) {
+    return evaluateBits(b);
 }
 
 TreeNode* Game::buildGameTree(char b[3][3], char currentPlayer) {
-    TreeNode* node = new TreeNode(b, currentPlayer);
-    int score = evaluateBoard(b);
-    if (score != 0 || isDraw(b)) {
-        node->score = score;
-        return node;
-    }
-
-    char nextPlayer = (currentPlayer == 'X') ? 'O' : 'X';
-    for (int i = 0; i < 3; ++i) {
-        for (int j = 0; j < 3; ++j) {
-            if (b[i][j] == ' ') {
-                char newBoard[3][3];
-                for (int x = 0; x < 3; ++x)
-                    for (int y = 0; y < 3; ++y)
-                        newBoard[x][y] = b[x][y];
-
-                newBoard[i][j] = currentPlayer;
-                TreeNode* child = buildGameTree(newBoard, nextPlayer);
-                node->children.push_back(child);
-            }
-        }
-    }
+    return buildGameTree(toBitboard(b), currentPlayer);
+}
 
-    return node;
+TreeNode* Game::buildGameTree(const Bitboard& b, char currentPlayer) {
+    return tree.build(b, currentPlayer);
 }
 
 int Game::minimaxTree(TreeNode* node, bool isMaximizing) {
-    if (node->children.empty()) return node->score;
+    if (node->childCount == 0) return node->score;
+
+    // Transposed and symmetric positions share one score
+    uint64_t key = uint64_t(canonicalEncoding(node->board)) * 2 + isMaximizing;
+    TTEntry entry;
+    if (treeTT.probe(key, entry)) {
+        node->score = entry.score;
+        return entry.score;
+    }
 
     int bestScore = isMaximizing ? -1000 : 1000;
-    for (TreeNode* child : node->children) {
-        int score = minimaxTree(child, !isMaximizing);
+    for (int i = 0; i < node->childCount; ++i) {
+        int score = minimaxTree(tree.child(*node, i), !isMaximizing);
         bestScore = isMaximizing ? std::max(score, bestScore) : std::min(score, bestScore);
     }
 
     node->score = bestScore;
+    treeTT.store(key, bestScore, __builtin_popcount(~occupied(node->board) & FULL_BOARD), TT_EXACT);
     return bestScore;
 }
 
-void Game::makeAIMoveWithTree() {
-    char tempBoard[3][3];
-    for (int i = 0; i < 3; ++i)
-        for (int j = 0; j < 3; ++j)
-            tempBoard[i][j] = board[i][j]; // convert vector to array
-
-    TreeNode* root = buildGameTree(tempBoard, 'O');
-    minimaxTree(root, true);
-
-    int bestScore = -1000;
-    TreeNode* bestMove = nullptr;
-    for (TreeNode* child : root->children) {
-        if (child->score > bestScore) {
-            bestScore = child->score;
-            bestMove = child;
+// Scores the root's children from the arena tree, then keeps the chosen
+// child as the new root. The tree is built once, from the empty board, and
+// any position that does not match the current root is found by walking
+// down from there; stones are taken in cell order, which reaches the same
+// node as the real move order since no subset of a live position is won.
+void Game::makeTreeMove() {
+    const Bitboard live = toBitboard(board);
+    auto matches = [&](const TreeNode* r) {
+        return r && r->board.x == live.x && r->board.o == live.o && r->player == currentPlayer;
+    };
+    TreeNode* root = tree.root();
+    if (!matches(root)) {
+        const TreeNode* base = tree.rewind() ? tree.root() : nullptr;
+        if (!base || base->board.x || base->board.o || base->player != 'X')
+            tree.build(Bitboard(), 'X');
+
+        uint16_t xs = live.x, os = live.o;
+        while (tree.root() && (xs || os)) {
+            uint16_t& mine = (tree.root()->player == 'X') ? xs : os;
+            if (!mine) break;
+            int cell = __builtin_ctz(mine);
+            mine &= mine - 1;
+            tree.advance(cell);
+        }
+        root = tree.root();
+    }
+    if (!matches(root))
+        root = tree.build(live, currentPlayer); // not reachable by alternating moves
+
+    const bool isMaximizing = (currentPlayer == 'O');
+    int bestScore = isMaximizing ? -1000 : 1000;
+    int bestMove = -1;
+    for (int i = 0; i < root->childCount; ++i) {
+        TreeNode* child = tree.child(*root, i);
+        int score = minimaxTree(child, !isMaximizing);
+        if (isMaximizing ? score > bestScore : score < bestScore) {
+            bestScore = score;
+            bestMove = child->move;
         }
     }
 
-    if (bestMove) {
-        for (int i = 0; i < 3; ++i)
-            for (int j = 0; j < 3; ++j)
-                board[i][j] = bestMove->board[i][j]; // update the actual vector board
+    if (bestMove >= 0) {
+        playCell(bestMove);
+    }
+}
+
+int Game::minimax(int depth, bool isMaximizing) {
+    char player = isMaximizing ? 'O' : 'X';
+    int score = searchEngine().alphaBeta(board, player, depth);
+    return isMaximizing ? score : -score;
+}
+
+int Game::findBestMove() {
+    return searchEngine().search(board, currentPlayer, limits).move;
+}
+
+TTStats Game::getSearchTTStats() const {
+    return searchEngine().ttStats();
+}
+
+TTStats Game::getTreeTTStats() const {
+    return treeTT.stats();
+}
+
+void Game::clearTranspositionTables() {
+    searchEngine().clear();
+    treeTT.clear();
+}
+
+void Game::makeAIMoveWithTree() {
+    if (!telemetry) {
+        playAIMove(nullptr);
+        return;
     }
 
-    delete root; // optional: can implement tree delete recursively if needed
+    MoveStats stats;
+    const AIMode backend = measureAIMove(stats);
+    telemetry->recordMove(backend, stats);
+}
+
+AIMode Game::measureAIMove(MoveStats& stats) {
+    const TTStats searchBefore = searchEngine().ttStats();
+    const TTStats treeBefore = treeTT.stats();
+    const AllocationCounter allocations;
+    const auto start = std::chrono::steady_clock::now();
+    AIMode backend = playAIMove(&stats);
+    stats.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    stats.allocations = allocations.count();
+
+    const TTStats searchAfter = searchEngine().ttStats();
+    const TTStats treeAfter = treeTT.stats();
+    stats.ttProbes = (searchAfter.probes - searchBefore.probes) + (treeAfter.probes - treeBefore.probes);
+    stats.ttHits = (searchAfter.hits - searchBefore.hits) + (treeAfter.hits - treeBefore.hits);
+    if (backend == AIMode::Tree) stats.nodes = treeAfter.probes - treeBefore.probes; // one probe per node
+    return backend;
 }
 
+AIMode Game::playAIMove(MoveStats* stats) {
+    const bool is3x3 = board.size() == 3 && board.winLength() == 3;
+    const int empties = board.cellCount() - board.moveCount();
+    if (aiMode == AIMode::Mcts) {
+        MctsResult result = mctsEngine().search(board, currentPlayer, mctsLimits);
+        if (result.move >= 0) playCell(result.move);
+        if (stats) {
+            stats->nodes = result.playouts;
+            stats->treeNodes = result.nodesUsed;
+            stats->depth = result.treeDepth;
+        }
+        return AIMode::Mcts;
+    }
+    if (is3x3 && aiMode == AIMode::Tree) {
+        makeTreeMove();
+        if (stats) {
+            stats->treeNodes = tree.size();
+            stats->depth = empties;
+        }
+        return AIMode::Tree;
+    }
+    if (is3x3 && aiMode == AIMode::Table) {
+        // Every position is solved at compile time (see SolvedTable.h), so picking
+        // a move is one table read. buildGameTree/minimaxTree give the same answer.
+        const SolvedEntry& best = solvedEntry(toBitboard(board), currentPlayer);
+        if (best.move >= 0) playCell(best.move);
+        if (stats) {
+            stats->nodes = 1;
+            stats->depth = empties;
+        }
+        return AIMode::Table;
+    }
+
+    // Larger boards: iterative deepening alpha-beta within the time budget
+    SearchResult result = searchEngine().search(board, currentPlayer, limits);
+    if (result.move >= 0) playCell(result.move);
+    if (stats) {
+        stats->nodes = result.nodes;
+        stats->depth = result.depth;
+    }
+    return AIMode::Search;
+}
@@ -0,0 +1,162 @@
+#include "../include/GameRecord.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char RECORD_MAGIC[4] = {'T', 'T', 'G', 'R'};
+const uint32_t RECORD_VERSION = 1;
+const size_t FILE_HEADER_BYTES = 8;
+
+void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(uint8_t(v >> (8 * i)));
+}
+
+} // namespace
+
+GameRecordWriter::GameRecordWriter(const std::string& path, size_t bufferBytes)
+    : bufferLimit(bufferBytes) {
+    file.open(path, std::ios::app | std::ios::binary);
+    buffer.reserve(bufferLimit + recordBytes(MAX_BOARD_SIZE, MAX_CELLS));
+    if (file && file.tellp() == 0) {
+        buffer.insert(buffer.end(), RECORD_MAGIC, RECORD_MAGIC + 4);
+        putU32(buffer, RECORD_VERSION);
+    }
+}
+
+GameRecordWriter::~GameRecordWriter() {
+    flush();
+}
+
+void GameRecordWriter::write(int size, int winLength, uint32_t playerX, uint32_t playerO,
+                             const uint8_t* cells, int moveCount, GameResult result) {
+    const int bits = bitsPerMove(size);
+    std::lock_guard<std::mutex> guard(lock);
+
+    buffer.push_back(uint8_t(size));
+    buffer.push_back(uint8_t(winLength));
+    uint16_t moves = uint16_t(moveCount | int(result) << 14);
+    buffer.push_back(uint8_t(moves));
+    buffer.push_back(uint8_t(moves >> 8));
+    putU32(buffer, playerX);
+    putU32(buffer, playerO);
+
+    uint32_t acc = 0;
+    int filled = 0;
+    for (int i = 0; i < moveCount; ++i) {
+        acc |= uint32_t(cells[i]) << filled;
+        filled += bits;
+        while (filled >= 8) {
+            buffer.push_back(uint8_t(acc));
+            acc >>= 8;
+            filled -= 8;
+        }
+    }
+    if (filled > 0) buffer.push_back(uint8_t(acc));
+
+    ++written;
+    if (buffer.size() >= bufferLimit) flushLocked();
+}
+
+void GameRecordWriter::flush() {
+    std::lock_guard<std::mutex> guard(lock);
+    flushLocked();
+}
+
+void GameRecordWriter::flushLocked() {
+    if (buffer.empty() || !file) return;
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    file.flush();
+    buffer.clear();
+}
+
+uint64_t GameRecordWriter::records() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return written;
+}
+
+int RecordView::move(int i) const {
+    const int bits = bitsPerMove(size());
+    const int bit = i * bits;
+    const uint8_t* p = data + RECORD_HEADER_BYTES + bit / 8;
+    // A cell spans at most two bytes; the second is only read when needed
+    uint32_t v = p[0];
+    if ((bit % 8) + bits > 8) v |= uint32_t(p[1]) << 8;
+    return int((v >> (bit % 8)) & ((1u << bits) - 1));
+}
+
+bool RecordView::replay(Board& board) const {
+    if (board.size() != size() || board.winLength() != winLength()) return false;
+    board.clear();
+    char player = 'X';
+    for (int i = 0; i < moveCount(); ++i) {
+        int cell = move(i);
+        if (cell >= board.cellCount() || !board.isEmpty(cell)) return false;
+        board.place(cell, player);
+        player = (player == 'X') ? 'O' : 'X';
+    }
+    return true;
+}
+
+GameRecordReader::GameRecordReader(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        failure = "cannot open " + path;
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < FILE_HEADER_BYTES) {
+        failure = "not a record file: " + path;
+        close(fd);
+        return;
+    }
+    void* mapped = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (mapped == MAP_FAILED) {
+        failure = "mmap failed: " + path;
+        return;
+    }
+    madvise(mapped, size_t(st.st_size), MADV_SEQUENTIAL);
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapped);
+    uint32_t version = uint32_t(bytes[4]) | uint32_t(bytes[5]) << 8 |
+                       uint32_t(bytes[6]) << 16 | uint32_t(bytes[7]) << 24;
+    if (std::memcmp(bytes, RECORD_MAGIC, 4) != 0 || version != RECORD_VERSION) {
+        failure = "not a record file: " + path;
+        munmap(mapped, size_t(st.st_size));
+        return;
+    }
+    data = bytes;
+    length = size_t(st.st_size);
+}
+
+GameRecordReader::~GameRecordReader() {
+    if (data) munmap(const_cast<uint8_t*>(data), length);
+}
+
+GameRecordReader::iterator GameRecordReader::begin() const {
+    if (!data) return iterator(nullptr, nullptr);
+    return iterator(data + FILE_HEADER_BYTES, data + length);
+}
+
+GameRecordReader::iterator GameRecordReader::end() const {
+    if (!data) return iterator(nullptr, nullptr);
+    return iterator(data + length, data + length);
+}
+
+void GameRecordReader::iterator::check() {
+    if (at == end) return;
+    size_t left = size_t(end - at);
+    if (left < size_t(RECORD_HEADER_BYTES)) {
+        at = end;
+        return;
+    }
+    int n = view.size();
+    if (n < 3 || n > MAX_BOARD_SIZE || view.winLength() < 3 || view.winLength() > n ||
+        view.moveCount() > n * n || view.bytes() > left)
+        at = end;
+    view = RecordView(at);
+}
@@ -0,0 +1,379 @@
+#include "../include/GameServer.h"
+#include "../include/Telemetry.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t MAX_LINE = 256;   // longer input without a newline closes the connection
+const int MAX_EVENTS = 256;
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+std::string outcome(Game& game) {
+    if (game.checkWin()) return std::string("END ") + game.getCurrentPlayer();
+    if (game.checkDraw()) return "END DRAW";
+    return "";
+}
+
+} // namespace
+
+struct GameServer::Session {
+    int fd;
+    std::string in;
+    std::string out;
+    std::string user;
+    bool loggedIn = false;
+    bool busy = false;         // an AI move is queued or running; the game belongs to a worker
+    bool closed = false;
+    bool closeAfterWrite = false;
+    bool over = false;         // I/O thread only
+    std::unique_ptr<Game> game;
+    std::string reply;         // written by the worker, sent by the I/O thread
+    bool replyEnds = false;    // written by the worker: the AI's move ended the game
+
+    explicit Session(int fd) : fd(fd) {}
+};
+
+GameServer::GameServer(const ServerConfig& config, UserStore& users)
+    : config(config), users(users) {}
+
+GameServer::~GameServer() {
+    stop();
+    {
+        std::lock_guard<std::mutex> guard(jobLock);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (auto& t : workers) t.join();
+
+    for (auto& entry : sessions) ::close(entry.first);
+    if (listenFd >= 0) ::close(listenFd);
+    if (epollFd >= 0) ::close(epollFd);
+    if (wakeFd >= 0) ::close(wakeFd);
+    if (!config.unixPath.empty()) ::unlink(config.unixPath.c_str());
+}
+
+bool GameServer::start(std::string& error) {
+    if (config.unixPath.empty()) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(config.port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            error = std::string("bind: ") + std::strerror(errno);
+            return false;
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &len);
+        boundPort = ntohs(addr.sin_port);
+    } else {
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (config.unixPath.size() >= sizeof(addr.sun_path)) {
+            error = "unix socket path too long";
+            return false;
+        }
+        std::strcpy(addr.sun_path, config.unixPath.c_str());
+        ::unlink(config.unixPath.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            error = std::string("bind: ") + std::strerror(errno);
+            return false;
+        }
+    }
+    if (listen(listenFd, SOMAXCONN) < 0 || !setNonBlocking(listenFd)) {
+        error = std::string("listen: ") + std::strerror(errno);
+        return false;
+    }
+
+    epollFd = epoll_create1(0);
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    int count = config.workers > 0 ? config.workers : (int)std::thread::hardware_concurrency();
+    for (int i = 0; i < std::max(1, count); ++i)
+        workers.emplace_back(&GameServer::workerLoop, this);
+    running = true;
+    return true;
+}
+
+void GameServer::stop() {
+    running = false;
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void GameServer::run() {
+    epoll_event events[MAX_EVENTS];
+    while (running) {
+        int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptAll();
+            } else if (fd == wakeFd) {
+                drainCompletions();
+            } else {
+                auto it = sessions.find(fd);
+                if (it == sessions.end()) continue;
+                std::shared_ptr<Session> s = it->second;
+                if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                    close(*s);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN) onReadable(s);
+                if (!s->closed && (events[i].events & EPOLLOUT)) onWritable(*s);
+            }
+        }
+    }
+}
+
+void GameServer::acceptAll() {
+    for (;;) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) return; // EAGAIN: backlog drained
+        setNonBlocking(fd);
+        if (config.unixPath.empty()) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        sessions[fd] = std::make_shared<Session>(fd);
+    }
+}
+
+void GameServer::onReadable(const std::shared_ptr<Session>& s) {
+    char buf[4096];
+    for (;;) {
+        ssize_t n = read(s->fd, buf, sizeof(buf));
+        if (n > 0) {
+            s->in.append(buf, n);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            close(*s);
+            return;
+        }
+        break;
+    }
+
+    size_t start = 0, nl;
+    while (!s->closed && !s->closeAfterWrite && (nl = s->in.find('\n', start)) != std::string::npos) {
+        std::string line = s->in.substr(start, nl - start);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        start = nl + 1;
+        handleLine(s, line);
+    }
+    if (s->closed) return;
+    s->in.erase(0, start);
+    if (s->in.size() > MAX_LINE) close(*s);
+}
+
+void GameServer::handleLine(const std::shared_ptr<Session>& s, const std::string& line) {
+    std::istringstream args(line);
+    std::string cmd;
+    args >> cmd;
+
+    if (cmd == "SIGNUP" || cmd == "LOGIN") {
+        std::string user, pass;
+        args >> user >> pass;
+        if (cmd == "SIGNUP") {
+            send(*s, users.add(user, pass) ? "OK\n" : "ERR taken\n");
+        } else if (users.check(user, pass)) {
+            s->user = user;
+            s->loggedIn = true;
+            send(*s, "OK\n");
+        } else {
+            send(*s, "ERR auth\n");
+        }
+    } else if (cmd == "NEW") {
+        int size = 3, win = 3;
+        std::string ai = "table";
+        if (args >> size) {
+            if (!(args >> win)) win = size;
+            args >> ai;
+        }
+        AIMode mode;
+        if (ai == "table") mode = AIMode::Table;
+        else if (ai == "search") mode = AIMode::Search;
+        else if (ai == "mcts") mode = AIMode::Mcts;
+        else mode = AIMode::Tree; // rejected below: a full tree per session is too big
+
+        if (!s->loggedIn) send(*s, "ERR login\n");
+        else if (s->busy) send(*s, "ERR busy\n");
+        else if (size < 3 || size > MAX_BOARD_SIZE || win < 3 || win > size || mode == AIMode::Tree)
+            send(*s, "ERR args\n");
+        else {
+            if (s->game && s->game->getSize() == size && s->game->getWinLength() == win) {
+                s->game->reset();
+            } else {
+                s->game.reset(new Game(size, win));
+                s->game->setSearchLimits(config.searchLimits);
+                s->game->setMctsLimits(config.mctsLimits);
+                s->game->setTelemetry(config.telemetry);
+            }
+            s->game->setAIMode(mode);
+            s->game->setRecorder(config.recorder, 0, 1 + uint32_t(mode));
+            s->over = false;
+            send(*s, "OK " + std::to_string(size) + " " + std::to_string(win) + "\n");
+        }
+    } else if (cmd == "MOVE") {
+        int row = -1, col = -1;
+        args >> row >> col;
+        if (s->busy) send(*s, "ERR busy\n");
+        else if (!s->game || s->over) send(*s, "ERR nogame\n");
+        else if (!s->game->makeMove(row, col)) send(*s, "ERR illegal\n");
+        else {
+            std::string end = outcome(*s->game);
+            if (!end.empty()) {
+                s->over = true;
+                send(*s, end + "\n");
+            } else {
+                s->game->switchPlayer();
+                s->busy = true;
+                {
+                    std::lock_guard<std::mutex> guard(jobLock);
+                    jobs.push_back(s);
+                }
+                jobReady.notify_one();
+            }
+        }
+    } else if (cmd == "PING") {
+        send(*s, "PONG\n");
+    } else if (cmd == "STATS") {
+        send(*s, config.telemetry ? "STATS " + config.telemetry->toJson() + "\n" : "ERR notelemetry\n");
+    } else if (cmd == "QUIT") {
+        // A pending AI reply still goes out first
+        s->closeAfterWrite = true;
+        if (!s->busy) send(*s, "BYE\n");
+    } else if (!cmd.empty()) {
+        send(*s, "ERR unknown\n");
+    }
+}
+
+// Runs on a worker thread: the session's game is only touched here while busy.
+// Every game this worker moves for searches on the worker's engines, so the
+// search tables cost one set per worker rather than one per session.
+void GameServer::workerLoop() {
+    SearchEngine searchEngine;
+    MctsEngine mctsEngine;
+    for (;;) {
+        std::shared_ptr<Session> s;
+        {
+            std::unique_lock<std::mutex> guard(jobLock);
+            jobReady.wait(guard, [&] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            s = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Game& game = *s->game;
+        game.lendEngines(&searchEngine, &mctsEngine);
+        game.makeAIMoveWithTree();
+        game.lendEngines(nullptr, nullptr);
+        int cell = game.getLastMove();
+        int n = game.getSize();
+        std::string reply = "AI " + std::to_string(cell / n) + " " + std::to_string(cell % n);
+        std::string end = outcome(game);
+        if (end.empty()) game.switchPlayer();
+        else reply += " " + end;
+        s->reply = reply + "\n";
+        s->replyEnds = !end.empty();
+
+        {
+            std::lock_guard<std::mutex> guard(doneLock);
+            done.push_back(std::move(s));
+        }
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void GameServer::drainCompletions() {
+    uint64_t count;
+    ssize_t ignored = read(wakeFd, &count, sizeof(count));
+    (void)ignored;
+
+    std::vector<std::shared_ptr<Session>> ready;
+    {
+        std::lock_guard<std::mutex> guard(doneLock);
+        ready.swap(done);
+    }
+    for (auto& s : ready) {
+        s->busy = false;
+        s->over = s->replyEnds;
+        if (!s->closed) send(*s, s->closeAfterWrite ? s->reply + "BYE\n" : s->reply);
+    }
+}
+
+void GameServer::send(Session& s, const std::string& text) {
+    bool idle = s.out.empty();
+    s.out += text;
+    if (idle) onWritable(s);
+}
+
+void GameServer::onWritable(Session& s) {
+    while (!s.out.empty()) {
+        ssize_t n = ::send(s.fd, s.out.data(), s.out.size(), MSG_NOSIGNAL); // a closed peer is an error, not SIGPIPE
+        if (n > 0) {
+            s.out.erase(0, n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Socket full: wait for EPOLLOUT
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLOUT;
+            ev.data.fd = s.fd;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, s.fd, &ev);
+            return;
+        }
+        close(s);
+        return;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = s.fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, s.fd, &ev);
+    if (s.closeAfterWrite && !s.busy) close(s);
+}
+
+// A worker may still hold the session; it is freed when that job completes
+void GameServer::close(Session& s) {
+    if (s.closed) return;
+    s.closed = true;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, s.fd, nullptr);
+    ::close(s.fd);
+    sessions.erase(s.fd);
+}
@@ -0,0 +1,75 @@
+#include "../include/GameTree.h"
+
+// Size of the full tree from the empty board; reserving it up front means
+// the arena grows at most once per game.
+static const size_t FULL_TREE_NODES = 549946;
+
+TreeNode* GameTree::build(const Bitboard& b, char player) {
+    nodes.clear();
+    if (nodes.capacity() == 0) nodes.reserve(FULL_TREE_NODES);
+
+    nodes.push_back(TreeNode{b, player, -1, 0, 0, -1});
+    rootIndex = 0;
+    expand(0);
+    return &nodes[0];
+}
+
+void GameTree::expand(int index) {
+    const Bitboard b = nodes[index].board;
+    const char player = nodes[index].player;
+    int score = evaluateBits(b);
+    uint16_t empty = ~occupied(b) & FULL_BOARD;
+    if (score != 0 || empty == 0) {
+        nodes[index].score = score;
+        return;
+    }
+
+    // Allocate all children as one block, then expand each of them.
+    // Indices, not pointers, are held here because the arena may grow.
+    const char nextPlayer = (player == 'X') ? 'O' : 'X';
+    const int first = static_cast<int>(nodes.size());
+    int count = 0;
+    for (int i = 0; i < 9; ++i) {
+        uint16_t bit = 1u << i;
+        if (!(empty & bit)) continue;
+        Bitboard child = b;
+        bitsFor(child, player) |= bit;
+        nodes.push_back(TreeNode{child, nextPlayer, static_cast<int8_t>(i), 0, 0, -1});
+        ++count;
+    }
+    nodes[index].firstChild = first;
+    nodes[index].childCount = static_cast<uint8_t>(count);
+
+    for (int i = 0; i < count; ++i)
+        expand(first + i);
+}
+
+bool GameTree::advance(int move) {
+    if (rootIndex < 0) return false;
+
+    const TreeNode& r = nodes[rootIndex];
+    for (int i = 0; i < r.childCount; ++i) {
+        if (nodes[r.firstChild + i].move == move) {
+            rootIndex = r.firstChild + i;
+            return true;
+        }
+    }
+    reset();
+    return false;
+}
+
+bool GameTree::rewind() {
+    if (nodes.empty()) return false;
+    rootIndex = 0;
+    return true;
+}
+
+void GameTree::reset() {
+    nodes.clear();
+    rootIndex = -1;
+}
+
+void GameTree::release() {
+    std::vector<TreeNode>().swap(nodes);
+    rootIndex = -1;
+}
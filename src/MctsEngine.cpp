@@ -0,0 +1,245 @@
+#include "../include/MctsEngine.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace {
+
+char opponent(char player) {
+    return (player == 'X') ? 'O' : 'X';
+}
+
+uint64_t nextRandom(uint64_t& state) {
+    // xorshift64*: fast, and each thread owns its own state
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+
+// Cells worth trying from this position; on boards larger than 5x5 only the
+// ones within two of an existing stone, as in SearchEngine.
+int candidateMoves(const Board& board, int* moves) {
+    const int n = board.size();
+    const int cells = board.cellCount();
+    int count = 0;
+    if (n > 5 && board.moveCount() > 0) {
+        bool near[MAX_CELLS] = {};
+        for (int c = 0; c < cells; ++c) {
+            if (board.isEmpty(c)) continue;
+            int r0 = c / n, c0 = c % n;
+            for (int r = std::max(0, r0 - 2); r <= std::min(n - 1, r0 + 2); ++r)
+                for (int cc = std::max(0, c0 - 2); cc <= std::min(n - 1, c0 + 2); ++cc)
+                    near[r * n + cc] = true;
+        }
+        for (int c = 0; c < cells; ++c)
+            if (near[c] && board.isEmpty(c)) moves[count++] = c;
+    }
+    if (count == 0) {
+        for (int c = 0; c < cells; ++c)
+            if (board.isEmpty(c)) moves[count++] = c;
+    }
+    return count;
+}
+
+} // namespace
+
+MctsEngine::MctsEngine(size_t poolSize) : capacity(poolSize) {}
+
+int MctsEngine::newNodes(int count) {
+    if (used.load(std::memory_order_relaxed) + count > static_cast<int>(capacity)) return -1;
+    int first = used.fetch_add(count);
+    if (first + count > static_cast<int>(capacity)) return -1;
+    return first;
+}
+
+void MctsEngine::initNode(int index, int parent, int move, char mover, char winner) {
+    Node& n = pool[index];
+    n.visits.store(0, std::memory_order_relaxed);
+    n.reward.store(0, std::memory_order_relaxed);
+    n.firstChild.store(-1, std::memory_order_relaxed);
+    n.state.store(0, std::memory_order_relaxed);
+    n.parent = parent;
+    n.move = static_cast<int16_t>(move);
+    n.childCount = 0;
+    n.mover = mover;
+    n.winner = winner;
+}
+
+// Caller has won the 0 -> 1 transition on node.state
+void MctsEngine::expand(int index, Board& board, char toMove) {
+    Node& n = pool[index];
+    if (used.load(std::memory_order_relaxed) >= static_cast<int>(capacity)) {
+        n.state.store(0, std::memory_order_release); // pool is full, stay a leaf
+        return;
+    }
+
+    int moves[MAX_CELLS];
+    int count = candidateMoves(board, moves);
+    int first = newNodes(count);
+    if (first < 0) {
+        n.state.store(0, std::memory_order_release); // pool is full, stay a leaf
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        board.place(moves[i], toMove);
+        char winner = board.isWinningMove(moves[i]) ? toMove : (board.isFull() ? 'D' : 0);
+        board.remove(moves[i]);
+        initNode(first + i, index, moves[i], toMove, winner);
+    }
+    n.firstChild.store(first, std::memory_order_relaxed);
+    n.childCount = static_cast<uint16_t>(count);
+    n.state.store(2, std::memory_order_release);
+}
+
+int MctsEngine::selectChild(const Node& node, double exploration) const {
+    const int first = node.firstChild.load(std::memory_order_relaxed);
+    const double logN = std::log(std::max(1, node.visits.load(std::memory_order_relaxed)));
+    int best = first;
+    double bestValue = -1e300;
+    for (int i = 0; i < node.childCount; ++i) {
+        const Node& c = pool[first + i];
+        int v = c.visits.load(std::memory_order_relaxed);
+        if (v == 0) return first + i;
+        double value = c.reward.load(std::memory_order_relaxed) / (2.0 * v)
+                     + exploration * std::sqrt(logN / v);
+        if (value > bestValue) {
+            bestValue = value;
+            best = first + i;
+        }
+    }
+    return best;
+}
+
+char MctsEngine::playout(Board& board, char toMove, uint64_t& rng) const {
+    int empties[MAX_CELLS];
+    int count = 0;
+    for (int c = 0; c < board.cellCount(); ++c)
+        if (board.isEmpty(c)) empties[count++] = c;
+
+    while (count > 0) {
+        int i = static_cast<int>(nextRandom(rng) % count);
+        int cell = empties[i];
+        empties[i] = empties[--count];
+        board.place(cell, toMove);
+        if (board.isWinningMove(cell)) return toMove;
+        toMove = opponent(toMove);
+    }
+    return 'D';
+}
+
+void MctsEngine::runThread(const Board& root, char player, const MctsLimits& limits, uint64_t seed) {
+    uint64_t rng = seed ? seed : 1;
+    int path[MAX_CELLS + 1];
+    const bool timed = limits.timeBudgetMs > 0;
+    int maxDepth = 0;
+
+    for (uint64_t iter = 0;; ++iter) {
+        if (playoutsLeft.fetch_sub(1, std::memory_order_relaxed) <= 0) break;
+        if ((iter & 63) == 0) {
+            if (timed && std::chrono::steady_clock::now() >= deadline) break;
+            if (limits.stop && limits.stop->load(std::memory_order_relaxed)) break;
+        }
+
+        Board board = root;
+        char toMove = player;
+        int node = 0;
+        int depth = 0;
+        path[depth++] = 0;
+        pool[0].visits.fetch_add(1, std::memory_order_relaxed);
+
+        char result = 0;
+        for (;;) {
+            Node& n = pool[node];
+            if (n.winner) {
+                result = n.winner;
+                break;
+            }
+            uint8_t state = n.state.load(std::memory_order_acquire);
+            if (state == 0 && n.visits.load(std::memory_order_relaxed) > 1) {
+                uint8_t expected = 0;
+                if (n.state.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+                    expand(node, board, toMove);
+                    state = n.state.load(std::memory_order_acquire);
+                }
+            }
+            if (state != 2) break; // leaf: play out from here
+
+            // The visit is counted before the result is known (virtual loss),
+            // which steers other threads to different children meanwhile
+            int child = selectChild(n, limits.exploration);
+            pool[child].visits.fetch_add(1, std::memory_order_relaxed);
+            board.place(pool[child].move, toMove);
+            toMove = opponent(toMove);
+            node = child;
+            path[depth++] = child;
+        }
+
+        maxDepth = std::max(maxDepth, depth - 1);
+        if (!result) result = playout(board, toMove, rng);
+        for (int i = 0; i < depth; ++i) {
+            Node& n = pool[path[i]];
+            int reward = (result == 'D') ? 1 : (result == n.mover ? 2 : 0);
+            if (reward) n.reward.fetch_add(reward, std::memory_order_relaxed);
+        }
+        playoutsDone.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int seen = deepest.load();
+    while (maxDepth > seen && !deepest.compare_exchange_weak(seen, maxDepth)) {}
+}
+
+MctsResult MctsEngine::search(const Board& board, char player, const MctsLimits& limits) {
+    const auto start = std::chrono::steady_clock::now();
+    MctsResult result;
+    if (board.isFull() || board.hasWon('X') || board.hasWon('O')) return result;
+
+    if (!pool) pool.reset(new Node[capacity]);
+    used.store(1);
+    initNode(0, -1, -1, opponent(player), 0);
+    Board rootBoard = board;
+    pool[0].state.store(1);
+    expand(0, rootBoard, player);
+
+    deadline = start + std::chrono::milliseconds(limits.timeBudgetMs);
+    playoutsLeft.store(limits.playouts > 0 ? limits.playouts : INT_MAX);
+    playoutsDone.store(0);
+    deepest.store(0);
+
+    const int threads = std::max(1, limits.threads);
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; ++t)
+        workers.emplace_back(&MctsEngine::runThread, this, std::cref(board), player,
+                                  std::cref(limits), limits.seed + 0x9E3779B97F4A7C15ull * t);
+    runThread(board, player, limits, limits.seed);
+    for (auto& th : workers) th.join();
+
+    const Node& root = pool[0];
+    const int first = root.firstChild.load();
+    int bestVisits = -1;
+    for (int i = 0; i < root.childCount; ++i) {
+        const Node& c = pool[first + i];
+        int v = c.visits.load();
+        // A move that wins on the spot is taken whatever the statistics say
+        if (c.winner == player) {
+            result.move = c.move;
+            result.winRate = 1.0;
+            break;
+        }
+        if (v > bestVisits) {
+            bestVisits = v;
+            result.move = c.move;
+            result.winRate = v ? c.reward.load() / (2.0 * v) : 0.0;
+        }
+    }
+
+    result.playouts = playoutsDone.load();
+    result.nodesUsed = std::min<size_t>(used.load(), capacity);
+    result.treeDepth = deepest.load();
+    result.elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
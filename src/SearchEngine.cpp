@@ -0,0 +1,372 @@
+#include "../include/SearchEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "../include/FixedBoard.h"
+#include "../include/Tablebase.h"
+
+namespace {
+
+constexpr int INF = WIN_SCORE + 1000;
+constexpr uint64_t SIDE_KEY = 0x5A17D3C2B9E1F00Dull; // mixed in when O is to move
+
+// Zobrist keys depend only on the cell, so the same stones on another board
+// size or win length hash alike; this keeps the variants apart in a table
+// shared between games (see Game::lendEngines). Both steps are bijective,
+// so no two variants get the same key.
+constexpr uint64_t variantKey(int size, int winLength) {
+    uint64_t z = uint64_t(size * 32 + winLength) * 0x9E3779B97F4A7C15ull;
+    return z ^ (z >> 29);
+}
+
+char opponent(char player) {
+    return (player == 'X') ? 'O' : 'X';
+}
+
+// Win scores are stored relative to the node so a hit stays exact at any ply
+int scoreToTT(int score, int ply) {
+    if (score > HEURISTIC_LIMIT) return score + ply;
+    if (score < -HEURISTIC_LIMIT) return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score > HEURISTIC_LIMIT) return score - ply;
+    if (score < -HEURISTIC_LIMIT) return score + ply;
+    return score;
+}
+
+bool probeTablebase(const Tablebase* tablebase, const Board& board, int& value, int& distance) {
+    return tablebase->probe(board, value, distance);
+}
+
+template <int N, int K>
+bool probeTablebase(const Tablebase* tablebase, const FixedBoard<N, K>& board, int& value, int& distance) {
+    return tablebase->probe(N, K, board.bits('X'), board.bits('O'), value, distance);
+}
+
+// Set cells of a FixedBoard mask (one word) or a Board mask, in cell order
+bool any(uint64_t mask) {
+    return mask != 0;
+}
+
+bool any(const BoardMask& mask) {
+    return mask.any();
+}
+
+template <typename F>
+void forEachCell(uint64_t mask, F&& f, int base = 0) {
+    for (; mask; mask &= mask - 1) f(base + __builtin_ctzll(mask));
+}
+
+template <typename F>
+void forEachCell(const BoardMask& mask, F&& f) {
+    for (int i = 0; i < BOARD_WORDS; ++i) forEachCell(mask.w[i], f, i * 64);
+}
+
+// Empty cells worth searching, in cell order. Boards larger than 5x5 only
+// consider cells within two of an existing stone (the geometry's nearMask).
+template <typename B>
+int candidateCells(const B& board, int* moves) {
+    auto cells = board.empties();
+    if (board.size() > 5 && board.moveCount() > 0) {
+        const auto& geo = board.geometry();
+        decltype(cells) near{};
+        auto stones = board.bits('X');
+        stones |= board.bits('O');
+        forEachCell(stones, [&](int c) { near |= geo.nearMask[c]; });
+        near &= cells;
+        if (any(near)) cells = near;
+    }
+    int count = 0;
+    forEachCell(cells, [&](int c) { moves[count++] = c; });
+    return count;
+}
+
+} // namespace
+
+SearchEngine::SearchEngine(int ttSizeLog2) : tt(ttSizeLog2), history{} {}
+
+void SearchEngine::clear() {
+    tt.clear();
+    ttCounters = TTCounters{};
+    for (SearchEngine& helper : helpers) helper.clear();
+    std::memset(history, 0, sizeof(history));
+}
+
+TTStats SearchEngine::ttStats() const {
+    TTCounters total = ttCounters;
+    for (const SearchEngine& helper : helpers) total += helper.ttCounters;
+    return tt.stats(total);
+}
+
+bool SearchEngine::outOfTime() {
+    if ((nodes & 1023) == 0) {
+        if (timed && std::chrono::steady_clock::now() >= deadline) stopped = true;
+        if (stopFlag && stopFlag->load(std::memory_order_relaxed)) stopped = true;
+    }
+    return stopped;
+}
+
+// Open windows only: a window holding stones of both players can never be
+// completed. Each open window is worth more the fuller it is.
+template <typename B>
+int SearchEngine::evaluate(const B& board, char player) const {
+    long long total = 0;
+    const int windows = board.geometry().windowCount;
+    for (int w = 0; w < windows; ++w) {
+        int cx = board.windowStones('X', w);
+        int co = board.windowStones('O', w);
+        if (cx && co) continue;
+        if (co) total += 1ll << std::min(3 * (co - 1), 12);
+        else if (cx) total -= 1ll << std::min(3 * (cx - 1), 12);
+    }
+    total = std::max<long long>(-(HEURISTIC_LIMIT - 1), std::min<long long>(HEURISTIC_LIMIT - 1, total));
+    return static_cast<int>(player == 'O' ? total : -total);
+}
+
+// Fills moves with the candidate cells, best first: the TT move, then by
+// history score, then closest to the centre.
+template <typename B>
+int SearchEngine::generateMoves(const B& board, int ttMove, char player, int* moves) const {
+    const int n = board.size();
+    const int count = candidateCells(board, moves);
+
+    const int p = (player == 'X') ? 0 : 1;
+    int keys[MAX_CELLS];
+    for (int i = 0; i < count; ++i) {
+        int c = moves[i];
+        int dr = 2 * (c / n) - (n - 1), dc = 2 * (c % n) - (n - 1);
+        int centrality = 4 * n - std::abs(dr) - std::abs(dc);
+        keys[i] = (c == ttMove) ? (1 << 30) : history[p][c] * 64 + centrality;
+    }
+    // Insertion sort: lists are short and usually nearly sorted
+    for (int i = 1; i < count; ++i) {
+        int m = moves[i], k = keys[i], j = i - 1;
+        while (j >= 0 && keys[j] < k) {
+            moves[j + 1] = moves[j];
+            keys[j + 1] = keys[j];
+            --j;
+        }
+        moves[j + 1] = m;
+        keys[j + 1] = k;
+    }
+    return count;
+}
+
+template <typename B>
+int SearchEngine::negamax(B& board, char player, int depth, int alpha, int beta, int ply) {
+    ++nodes;
+    if (outOfTime()) return 0;
+    if (board.isFull()) return 0;
+
+    int value, distance;
+    if (tablebase && probeTablebase(tablebase, board, value, distance))
+        return value * (WIN_SCORE - (ply + distance)); // the game ends `distance` plies on
+    if (depth <= 0) return evaluate(board, player);
+
+    const auto& geo = board.geometry();
+    const int sym = board.canonicalSymmetry();
+    const uint64_t key = board.hash(sym) ^ variantKey(board.size(), board.winLength()) ^
+                         (player == 'O' ? SIDE_KEY : 0);
+    const int alphaOrig = alpha;
+
+    TranspositionTable& table = sharedTT ? *sharedTT : tt;
+    int ttMove = -1;
+    TTEntry entry;
+    if (table.probe(key, entry, ttCounters)) {
+        if (entry.bestMove >= 0 && entry.bestMove < board.cellCount())
+            ttMove = geo.inverse[sym][entry.bestMove];
+        if (entry.depth >= depth) {
+            int s = scoreFromTT(entry.score, ply);
+            if (entry.flag == TT_EXACT) return s;
+            if (entry.flag == TT_LOWER && s >= beta) return s;
+            if (entry.flag == TT_UPPER && s <= alpha) return s;
+        }
+    }
+
+    int moves[MAX_CELLS];
+    int count = generateMoves(board, ttMove, player, moves);
+    int best = -INF;
+    int bestMove = -1;
+    for (int i = 0; i < count; ++i) {
+        int cell = moves[i];
+        board.place(cell, player);
+        int score = board.isWinningMove(cell)
+            ? WIN_SCORE - (ply + 1)
+            : -negamax(board, opponent(player), depth - 1, -beta, -alpha, ply + 1);
+        board.remove(cell);
+        if (stopped) return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = cell;
+        }
+        if (best > alpha) alpha = best;
+        if (alpha >= beta) {
+            history[player == 'X' ? 0 : 1][cell] += depth * depth;
+            break;
+        }
+    }
+
+    TTFlag flag = (best <= alphaOrig) ? TT_UPPER : (best >= beta ? TT_LOWER : TT_EXACT);
+    table.store(key, scoreToTT(best, ply), depth, flag, geo.symmetry[sym][bestMove], ttCounters);
+    return best;
+}
+
+int SearchEngine::alphaBeta(Board& board, char player, int depth) {
+    nodes = 0;
+    stopped = false;
+    timed = false;
+    tablebase = nullptr;
+    stopFlag = nullptr;
+    int value = 0;
+    if (!withFixedBoard(board.size(), board.winLength(), [&](auto fixedSize) {
+            typename decltype(fixedSize)::BoardType fixed(board);
+            value = negamax(fixed, player, depth, -INF, INF, 0);
+        }))
+        value = negamax(board, player, depth, -INF, INF, 0);
+    return value;
+}
+
+void SearchEngine::begin(const SearchLimits& limits, std::chrono::steady_clock::time_point start) {
+    nodes = 0;
+    stopped = false;
+    timed = limits.timeBudgetMs > 0;
+    tablebase = limits.tablebase;
+    stopFlag = limits.stop;
+    deadline = start + std::chrono::milliseconds(limits.timeBudgetMs);
+    for (auto& side : history)
+        for (int& h : side) h /= 2;
+}
+
+template <typename B>
+int SearchEngine::searchRootMove(B& board, char player, int cell, int depth, int alpha) {
+    board.place(cell, player);
+    int score = board.isWinningMove(cell)
+        ? WIN_SCORE - 1
+        : -negamax(board, opponent(player), depth - 1, -INF, -alpha, 1);
+    board.remove(cell);
+    return score;
+}
+
+// Searches moves[1..count) on `threads` threads after moves[0] has set best.
+// Windows open at best - 1 so a move that ties the best still comes back
+// exact. The move is only picked once every score is in, as the lowest
+// index with the best score, the same rule as the serial loop; the order in
+// which threads finish never decides it.
+template <typename B>
+bool SearchEngine::searchParallel(B& board, char player, const int* moves, int count,
+                                  int depth, int threads, int& best, int& bestIndex) {
+    std::vector<int> scores(count, -INF);
+    scores[0] = best;
+    std::atomic<int> next{1};
+    std::atomic<int> shared{best};
+
+    auto work = [&](SearchEngine& engine) {
+        B local = board;
+        for (int i = next++; i < count && !engine.stopped; i = next++) {
+            int score = engine.searchRootMove(local, player, moves[i], depth, shared.load() - 1);
+            if (engine.stopped) break;
+            scores[i] = score;
+            int seen = shared.load();
+            while (score > seen && !shared.compare_exchange_weak(seen, score)) {}
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads - 1; ++t)
+        pool.emplace_back(work, std::ref(helpers[t]));
+    work(*this);
+    for (auto& th : pool) th.join();
+
+    bool complete = !stopped;
+    for (int t = 0; t < threads - 1; ++t) {
+        nodes += helpers[t].nodes;
+        helpers[t].nodes = 0;
+        complete = complete && !helpers[t].stopped;
+    }
+    if (!complete) return false;
+
+    best = *std::max_element(scores.begin(), scores.end());
+    bestIndex = int(std::find(scores.begin(), scores.end(), best) - scores.begin());
+    return true;
+}
+
+// Iterative deepening from the root, leaving the last completed iteration
+// in result
+template <typename B>
+void SearchEngine::deepen(B& board, char player, const SearchLimits& limits, SearchResult& result) {
+    const int threads = std::max(1, limits.threads);
+    const int empties = board.cellCount() - board.moveCount();
+    int moves[MAX_CELLS];
+    int count = generateMoves(board, -1, player, moves);
+    result.move = moves[0]; // something legal even if depth 1 runs out of time
+
+    const int maxDepth = std::min(limits.maxDepth, empties);
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        int best = searchRootMove(board, player, moves[0], depth, -INF);
+        int bestIndex = 0;
+        if (stopped) break;
+
+        if (threads > 1 && count > 1) {
+            if (!searchParallel(board, player, moves, count, depth, threads, best, bestIndex))
+                break; // keep the last completed iteration
+        } else {
+            for (int i = 1; i < count; ++i) {
+                int score = searchRootMove(board, player, moves[i], depth, best);
+                if (stopped) break;
+                if (score > best) {
+                    best = score;
+                    bestIndex = i;
+                }
+            }
+            if (stopped) break;
+        }
+
+        result.move = moves[bestIndex];
+        result.score = best;
+        result.depth = depth;
+        std::rotate(moves, moves + bestIndex, moves + bestIndex + 1); // search it first next time
+        if (std::abs(best) > HEURISTIC_LIMIT) break; // forced result found
+    }
+}
+
+SearchResult SearchEngine::search(Board& board, char player, const SearchLimits& limits) {
+    const auto start = std::chrono::steady_clock::now();
+    SearchResult result;
+    begin(limits, start);
+
+    const int threads = std::max(1, limits.threads);
+    while (static_cast<int>(helpers.size()) < threads - 1)
+        helpers.emplace_back(tt.sizeLog2());
+    if (threads > 1) tt.reserve(); // allocated before the helpers share it
+    for (int t = 0; t < threads - 1; ++t) {
+        helpers[t].begin(limits, start);
+        helpers[t].sharedTT = &tt;
+    }
+
+    const int empties = board.cellCount() - board.moveCount();
+    if (empties == 0 || board.hasWon('X') || board.hasWon('O')) return result;
+
+    int value, distance;
+    if (tablebase && (result.move = tablebase->bestMove(board, value, distance)) >= 0) {
+        result.score = value * (WIN_SCORE - distance);
+        result.depth = distance;
+        result.elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+    if (!withFixedBoard(board.size(), board.winLength(), [&](auto fixedSize) {
+            typename decltype(fixedSize)::BoardType fixed(board);
+            deepen(fixed, player, limits, result);
+        }))
+        deepen(board, player, limits, result);
+
+    result.nodes = nodes;
+    result.elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,130 @@
+#include "../include/SelfPlay.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint64_t BATCH = 64; // games claimed per trip to the shared counter
+
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void randomMove(Game& game, uint64_t& rng) {
+    const Board& b = game.getBoard();
+    int empties[MAX_CELLS];
+    int count = 0;
+    for (int c = 0; c < b.cellCount(); ++c)
+        if (b.isEmpty(c)) empties[count++] = c;
+    if (count == 0) return;
+
+    int cell = empties[splitmix64(rng) % count];
+    game.makeMove(cell / b.size(), cell % b.size());
+}
+
+uint32_t recordId(const PlayerSpec& p) {
+    return p.random ? 0 : 1 + uint32_t(p.mode);
+}
+
+} // namespace
+
+bool parsePlayer(const char* name, PlayerSpec& out) {
+    if (!std::strcmp(name, "random")) out = PlayerSpec{true, AIMode::Table};
+    else if (!std::strcmp(name, "table")) out = PlayerSpec{false, AIMode::Table};
+    else if (!std::strcmp(name, "tree")) out = PlayerSpec{false, AIMode::Tree};
+    else if (!std::strcmp(name, "search")) out = PlayerSpec{false, AIMode::Search};
+    else if (!std::strcmp(name, "mcts")) out = PlayerSpec{false, AIMode::Mcts};
+    else return false;
+    return true;
+}
+
+const char* playerName(const PlayerSpec& p) {
+    if (p.random) return "random";
+    switch (p.mode) {
+    case AIMode::Table: return "table";
+    case AIMode::Tree: return "tree";
+    case AIMode::Search: return "search";
+    case AIMode::Mcts: return "mcts";
+    }
+    return "?";
+}
+
+SelfPlayStats runSelfPlay(const SelfPlayConfig& config) {
+    const auto start = std::chrono::steady_clock::now();
+    int threads = config.threads > 0 ? config.threads : (int)std::thread::hardware_concurrency();
+    threads = std::max(1, threads);
+
+    std::atomic<uint64_t> nextGame{0};
+    std::mutex totalsLock;
+    SelfPlayStats totals;
+
+    auto worker = [&](int id) {
+        Game game(config.size, config.winLength);
+        SearchLimits searchLimits = config.searchLimits;
+        searchLimits.threads = 1;
+        game.setSearchLimits(searchLimits);
+        game.setRecorder(config.recorder, recordId(config.x), recordId(config.o));
+        game.setTelemetry(config.telemetry);
+        MctsLimits mctsLimits = config.mctsLimits;
+        mctsLimits.threads = 1;
+
+        uint64_t rng = config.seed ^ (0xD1B54A32D192ED03ull * (id + 1));
+        SelfPlayStats local;
+        for (;;) {
+            uint64_t first = nextGame.fetch_add(BATCH);
+            if (first >= config.games) break;
+            uint64_t last = std::min(config.games, first + BATCH);
+
+            for (uint64_t g = first; g < last; ++g) {
+                game.reset();
+                mctsLimits.seed = splitmix64(rng);
+                game.setMctsLimits(mctsLimits);
+                for (;;) {
+                    const PlayerSpec& side = (game.getCurrentPlayer() == 'X') ? config.x : config.o;
+                    if (side.random) {
+                        randomMove(game, rng);
+                    } else {
+                        game.setAIMode(side.mode);
+                        game.makeAIMoveWithTree();
+                    }
+                    ++local.moves;
+
+                    if (game.checkWin()) {
+                        ++(game.getCurrentPlayer() == 'X' ? local.xWins : local.oWins);
+                        break;
+                    }
+                    if (game.checkDraw()) {
+                        ++local.draws;
+                        break;
+                    }
+                    game.switchPlayer();
+                }
+                ++local.games;
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(totalsLock);
+        totals.games += local.games;
+        totals.xWins += local.xWins;
+        totals.oWins += local.oWins;
+        totals.draws += local.draws;
+        totals.moves += local.moves;
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return totals;
+}
@@ -0,0 +1,348 @@
+#include "../include/Tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char TABLEBASE_MAGIC[4] = {'T', 'T', 'T', 'B'};
+const uint32_t TABLEBASE_VERSION = 1;
+const size_t HEADER_BYTES = 16 + 8 * (TABLEBASE_MAX_CELLS + 1);
+const uint64_t CHUNK = 256; // occupied sets claimed per trip to the shared counter
+
+enum : uint8_t { TB_NONE = 0, TB_LOSS = 1, TB_DRAW = 2, TB_WIN = 3 };
+
+struct Binomials {
+    uint64_t c[TABLEBASE_MAX_CELLS + 1][TABLEBASE_MAX_CELLS + 1];
+};
+
+constexpr Binomials buildBinomials() {
+    Binomials b{};
+    for (int n = 0; n <= TABLEBASE_MAX_CELLS; ++n) {
+        b.c[n][0] = 1;
+        for (int k = 1; k <= n; ++k) b.c[n][k] = b.c[n - 1][k - 1] + b.c[n - 1][k];
+    }
+    return b;
+}
+
+constexpr Binomials BINOMIALS = buildBinomials();
+
+uint64_t binom(int n, int k) {
+    return (k < 0 || k > n) ? 0 : BINOMIALS.c[n][k];
+}
+
+uint64_t levelSize(int cells, int k) {
+    return binom(cells, k) * binom(k, (k + 1) / 2);
+}
+
+// Colex rank of the occupied set, times the number of ways to place X
+// within it, plus the colex rank of X's cells among the occupied ones
+uint64_t positionIndex(uint32_t x, uint32_t occ) {
+    const int k = __builtin_popcount(occ);
+    uint64_t occRank = 0, xRank = 0;
+    int i = 0, j = 0;
+    for (uint32_t m = occ; m; m &= m - 1, ++i) {
+        int cell = __builtin_ctz(m);
+        occRank += binom(cell, i + 1);
+        if ((x >> cell) & 1) xRank += binom(i, ++j);
+    }
+    return occRank * binom(k, (k + 1) / 2) + xRank;
+}
+
+uint32_t unrankColex(uint64_t rank, int k) {
+    uint32_t mask = 0;
+    for (int i = k; i >= 1; --i) {
+        int cell = i - 1;
+        while (binom(cell + 1, i) <= rank) ++cell;
+        mask |= 1u << cell;
+        rank -= binom(cell, i);
+    }
+    return mask;
+}
+
+// Next larger mask with the same number of bits (Gosper's hack), which is
+// the next set in colex order
+uint32_t nextCombination(uint32_t v) {
+    uint32_t t = v | (v - 1);
+    return (t + 1) | (((~t & (t + 1)) - 1) >> (__builtin_ctz(v) + 1));
+}
+
+// Spreads the low bits of pattern over the set bits of occ, lowest first
+uint32_t deposit(uint32_t pattern, uint32_t occ) {
+    uint32_t out = 0;
+    for (uint32_t m = occ; m; m &= m - 1, pattern >>= 1)
+        if (pattern & 1) out |= m & (0u - m);
+    return out;
+}
+
+std::vector<uint32_t> windowMasks(int n, int k) {
+    std::vector<uint32_t> masks;
+    const int dirs[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+    for (const auto& d : dirs)
+        for (int r = 0; r < n; ++r)
+            for (int c = 0; c < n; ++c) {
+                int er = r + d[0] * (k - 1), ec = c + d[1] * (k - 1);
+                if (er < 0 || er >= n || ec < 0 || ec >= n) continue;
+                uint32_t mask = 0;
+                for (int s = 0; s < k; ++s) mask |= 1u << ((r + d[0] * s) * n + c + d[1] * s);
+                masks.push_back(mask);
+            }
+    return masks;
+}
+
+bool anyLine(uint32_t bits, const std::vector<uint32_t>& masks) {
+    for (uint32_t m : masks)
+        if ((bits & m) == m) return true;
+    return false;
+}
+
+uint8_t makeEntry(uint8_t value, int distance) {
+    return uint8_t(value | distance << 2);
+}
+
+// Solves one position of level k from the entries of level k + 1
+uint8_t solvePosition(uint32_t x, uint32_t o, int k, int cells, const std::vector<uint32_t>& masks,
+                      const uint8_t* next) {
+    const bool xToMove = (k % 2) == 0;
+    if (anyLine(xToMove ? x : o, masks)) return TB_NONE; // the mover should already have won
+    if (anyLine(xToMove ? o : x, masks)) return makeEntry(TB_LOSS, 0);
+    if (k == cells) return makeEntry(TB_DRAW, 0);
+
+    int bestWin = 64, draw = -1, longestLoss = -1;
+    const uint32_t occ = x | o;
+    for (int cell = 0; cell < cells; ++cell) {
+        uint32_t bit = 1u << cell;
+        if (occ & bit) continue;
+        uint8_t e = next[positionIndex(xToMove ? x | bit : x, occ | bit)];
+        int d = (e >> 2) + 1;
+        switch (e & 3) {
+        case TB_LOSS: bestWin = std::min(bestWin, d); break;
+        case TB_DRAW: draw = d; break;
+        case TB_WIN: longestLoss = std::max(longestLoss, d); break;
+        }
+        if (bestWin == 1) break; // nothing beats winning now
+    }
+    if (bestWin < 64) return makeEntry(TB_WIN, bestWin);
+    if (draw >= 0) return makeEntry(TB_DRAW, draw);
+    return makeEntry(TB_LOSS, longestLoss);
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(char((v >> (8 * i)) & 0xFF));
+}
+
+void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(char((v >> (8 * i)) & 0xFF));
+}
+
+uint64_t getU64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+} // namespace
+
+Tablebase::~Tablebase() {
+    if (data) munmap(const_cast<uint8_t*>(data), length);
+}
+
+bool Tablebase::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < HEADER_BYTES) {
+        error = "not a tablebase: " + path;
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error = "mmap failed: " + path;
+        return false;
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mapped);
+    const size_t fileSize = size_t(st.st_size);
+    uint32_t version = uint32_t(bytes[4]) | uint32_t(bytes[5]) << 8 |
+                       uint32_t(bytes[6]) << 16 | uint32_t(bytes[7]) << 24;
+    int n = bytes[8], k = bytes[9], low = bytes[10];
+    bool ok = std::memcmp(bytes, TABLEBASE_MAGIC, 4) == 0 && version == TABLEBASE_VERSION &&
+              n >= 3 && n <= TABLEBASE_MAX_SIZE && k >= 3 && k <= n && low <= n * n;
+    uint64_t offsets[TABLEBASE_MAX_CELLS + 1] = {};
+    for (int level = 0; ok && level <= TABLEBASE_MAX_CELLS; ++level) {
+        offsets[level] = getU64(bytes + 16 + 8 * level);
+        if (level >= low && level <= n * n)
+            ok = offsets[level] >= HEADER_BYTES && offsets[level] + levelSize(n * n, level) <= fileSize;
+    }
+    if (!ok) {
+        error = "not a tablebase: " + path;
+        munmap(mapped, fileSize);
+        return false;
+    }
+
+    if (data) munmap(const_cast<uint8_t*>(data), length);
+    data = bytes;
+    length = fileSize;
+    boardSize = n;
+    win = k;
+    lowest = low;
+    std::copy(offsets, offsets + TABLEBASE_MAX_CELLS + 1, levelOffset);
+    return true;
+}
+
+bool Tablebase::probeBits(uint32_t x, uint32_t o, int& value, int& distance) const {
+    const uint32_t occ = x | o;
+    const int k = __builtin_popcount(occ);
+    if (k < lowest || __builtin_popcount(x) != (k + 1) / 2) return false;
+
+    uint8_t e = data[levelOffset[k] + positionIndex(x, occ)];
+    if ((e & 3) == TB_NONE) return false;
+    value = int(e & 3) - TB_DRAW;
+    distance = e >> 2;
+    return true;
+}
+
+bool Tablebase::probe(const Board& board, int& value, int& distance) const {
+    return probe(board.size(), board.winLength(), board.bits('X').w[0], board.bits('O').w[0], value, distance);
+}
+
+bool Tablebase::probe(int size, int winLength, uint64_t x, uint64_t o, int& value, int& distance) const {
+    if (!data || size != boardSize || winLength != win) return false;
+    return probeBits(uint32_t(x), uint32_t(o), value, distance);
+}
+
+int Tablebase::bestMove(const Board& board, int& value, int& distance) const {
+    if (!probe(board, value, distance) || distance == 0) return -1;
+
+    uint32_t x = uint32_t(board.bits('X').w[0]);
+    uint32_t o = uint32_t(board.bits('O').w[0]);
+    const bool xToMove = __builtin_popcount(x) == __builtin_popcount(o);
+    // The best child is the one whose own value and distance match ours
+    for (int cell = 0; cell < boardSize * boardSize; ++cell) {
+        uint32_t bit = 1u << cell;
+        if ((x | o) & bit) continue;
+        int childValue, childDistance;
+        if (!probeBits(xToMove ? x | bit : x, xToMove ? o : o | bit, childValue, childDistance)) continue;
+        if (-childValue == value && childDistance + 1 == distance) return cell;
+    }
+    return -1;
+}
+
+bool solveTablebase(const SolveConfig& config, SolveStats& stats, std::string& error) {
+    const auto start = std::chrono::steady_clock::now();
+    const int n = config.size;
+    const int cells = n * n;
+    if (n < 3 || n > TABLEBASE_MAX_SIZE || config.winLength < 3 || config.winLength > n) {
+        error = "tablebases cover 3x3 to 5x5 boards with 3 <= win <= size";
+        return false;
+    }
+    int low = config.minPieces >= 0 ? std::min(config.minPieces, cells) : (cells <= 16 ? 0 : cells - 1);
+    int threads = config.threads > 0 ? config.threads : (int)std::thread::hardware_concurrency();
+    threads = std::max(1, threads);
+
+    uint64_t offsets[TABLEBASE_MAX_CELLS + 1] = {};
+    uint64_t total = 0;
+    for (int k = low; k <= cells; ++k) {
+        offsets[k] = HEADER_BYTES + total;
+        total += levelSize(cells, k);
+    }
+    std::vector<uint8_t> table;
+    try {
+        table.resize(total);
+    } catch (const std::bad_alloc&) {
+        error = "not enough memory for " + std::to_string(total) + " entries; raise the minimum pieces";
+        return false;
+    }
+    const std::vector<uint32_t> masks = windowMasks(n, config.winLength);
+
+    // Full board first: every level reads only the one above it
+    for (int k = cells; k >= low; --k) {
+        uint8_t* level = table.data() + (offsets[k] - HEADER_BYTES);
+        const uint8_t* next = k < cells ? table.data() + (offsets[k + 1] - HEADER_BYTES) : nullptr;
+        const int xCount = (k + 1) / 2;
+        const uint64_t perOcc = binom(k, xCount);
+        const uint64_t occCount = binom(cells, k);
+        std::atomic<uint64_t> nextChunk{0};
+        std::atomic<uint64_t> wins{0}, draws{0}, losses{0};
+
+        auto work = [&] {
+            uint64_t w = 0, d = 0, l = 0;
+            for (;;) {
+                uint64_t first = nextChunk.fetch_add(CHUNK);
+                if (first >= occCount) break;
+                uint64_t last = std::min(occCount, first + CHUNK);
+                uint32_t occ = unrankColex(first, k);
+                for (uint64_t r = first; r < last; ++r) {
+                    uint32_t pattern = (1u << xCount) - 1;
+                    uint8_t* out = level + r * perOcc;
+                    for (uint64_t t = 0; t < perOcc; ++t) {
+                        uint32_t x = deposit(pattern, occ);
+                        uint8_t e = solvePosition(x, occ ^ x, k, cells, masks, next);
+                        out[t] = e;
+                        w += (e & 3) == TB_WIN;
+                        d += (e & 3) == TB_DRAW;
+                        l += (e & 3) == TB_LOSS;
+                        if (pattern) pattern = nextCombination(pattern);
+                    }
+                    if (occ) occ = nextCombination(occ);
+                }
+            }
+            wins += w;
+            draws += d;
+            losses += l;
+        };
+
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; ++t) pool.emplace_back(work);
+        work();
+        for (auto& th : pool) th.join();
+
+        stats.wins += wins;
+        stats.draws += draws;
+        stats.losses += losses;
+    }
+
+    std::string header;
+    header.append(TABLEBASE_MAGIC, 4);
+    putU32(header, TABLEBASE_VERSION);
+    header.push_back(char(n));
+    header.push_back(char(config.winLength));
+    header.push_back(char(low));
+    header.push_back(0);
+    putU32(header, 0);
+    for (int k = 0; k <= TABLEBASE_MAX_CELLS; ++k) putU64(header, offsets[k]);
+
+    // Write aside and rename, like the user snapshot
+    const std::string tmp = config.path + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f.write(header.data(), header.size()) ||
+            !f.write(reinterpret_cast<const char*>(table.data()), table.size())) {
+            error = "cannot write " + tmp;
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), config.path.c_str()) != 0) {
+        error = "cannot rename " + tmp;
+        return false;
+    }
+
+    stats.positions = total;
+    stats.bytes = header.size() + total;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
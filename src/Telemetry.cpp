@@ -0,0 +1,162 @@
+#include "../include/Telemetry.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+const char* BACKEND_NAMES[4] = {"table", "tree", "search", "mcts"};
+
+int64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void atomicMax(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t seen = target.load(std::memory_order_relaxed);
+    while (value > seen && !target.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+void atomicMin(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t seen = target.load(std::memory_order_relaxed);
+    while (value < seen && !target.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+// Bucket b < 32 holds exactly b. Above that, group g = b / 32 covers
+// [2^(g+4), 2^(g+5)) in 32 steps of 2^(g-1).
+int LatencyHistogram::bucketOf(uint64_t nanos) {
+    if (nanos < (1u << SUB_BITS)) return int(nanos);
+    int top = 63 - __builtin_clzll(nanos);
+    int shift = top - SUB_BITS;
+    return ((shift + 1) << SUB_BITS) + int((nanos >> shift) & ((1u << SUB_BITS) - 1));
+}
+
+uint64_t LatencyHistogram::upperEdge(int bucket) {
+    if (bucket < (1 << SUB_BITS)) return uint64_t(bucket);
+    int group = bucket >> SUB_BITS;
+    uint64_t low = uint64_t((1 << SUB_BITS) + (bucket & ((1 << SUB_BITS) - 1))) << (group - 1);
+    return low + (uint64_t(1) << (group - 1)) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    buckets[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanos, std::memory_order_relaxed);
+    atomicMin(smallest, nanos);
+    atomicMax(largest, nanos);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    smallest.store(UINT64_MAX, std::memory_order_relaxed);
+    largest.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::min() const {
+    return count() ? smallest.load(std::memory_order_relaxed) : 0;
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? double(sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) return 0;
+    uint64_t rank = uint64_t(p / 100.0 * n + 0.5);
+    rank = rank < 1 ? 1 : (rank > n ? n : rank);
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += buckets[b].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(upperEdge(b), max());
+    }
+    return max();
+}
+
+void Telemetry::recordMove(AIMode backend, const MoveStats& move) {
+    int64_t expected = 0;
+    started.compare_exchange_strong(expected, steadyNanos() - int64_t(move.nanos),
+                                    std::memory_order_relaxed);
+
+    Backend& b = stats[int(backend)];
+    b.moves.fetch_add(1, std::memory_order_relaxed);
+    b.nanos.fetch_add(move.nanos, std::memory_order_relaxed);
+    b.nodes.fetch_add(move.nodes, std::memory_order_relaxed);
+    b.ttProbes.fetch_add(move.ttProbes, std::memory_order_relaxed);
+    b.ttHits.fetch_add(move.ttHits, std::memory_order_relaxed);
+    b.allocations.fetch_add(move.allocations, std::memory_order_relaxed);
+    b.depthSum.fetch_add(uint64_t(move.depth), std::memory_order_relaxed);
+    atomicMax(b.peakTreeNodes, move.treeNodes);
+    if (move.pondered) b.ponderedMoves.fetch_add(1, std::memory_order_relaxed);
+    b.latency.record(move.nanos);
+}
+
+void Telemetry::recordPonder(AIMode backend, const MoveStats& search) {
+    Backend& b = stats[int(backend)];
+    b.ponderSearches.fetch_add(1, std::memory_order_relaxed);
+    b.ponderNodes.fetch_add(search.nodes, std::memory_order_relaxed);
+}
+
+void Telemetry::reset() {
+    for (Backend& b : stats) {
+        b.moves.store(0);
+        b.nanos.store(0);
+        b.nodes.store(0);
+        b.ttProbes.store(0);
+        b.ttHits.store(0);
+        b.allocations.store(0);
+        b.depthSum.store(0);
+        b.peakTreeNodes.store(0);
+        b.ponderedMoves.store(0);
+        b.ponderSearches.store(0);
+        b.ponderNodes.store(0);
+        b.latency.reset();
+    }
+    started.store(0);
+}
+
+std::string Telemetry::toJson() const {
+    int64_t since = started.load();
+    double uptime = since ? (steadyNanos() - since) / 1e9 : 0.0;
+    char buf[768];
+    std::snprintf(buf, sizeof(buf), "{\"uptime_s\":%.3f,\"backends\":{", uptime);
+    std::string out = buf;
+
+    bool first = true;
+    for (int i = 0; i < 4; ++i) {
+        const Backend& b = stats[i];
+        uint64_t moves = b.moves.load(), ponders = b.ponderSearches.load();
+        if (moves == 0 && ponders == 0) continue;
+        uint64_t nanos = b.nanos.load(), nodes = b.nodes.load();
+        uint64_t probes = b.ttProbes.load(), hits = b.ttHits.load();
+        const LatencyHistogram& h = b.latency;
+        std::snprintf(buf, sizeof(buf),
+                      "%s\"%s\":{\"moves\":%llu,\"nodes\":%llu,\"nodes_per_sec\":%.0f,"
+                      "\"tt_probes\":%llu,\"tt_hits\":%llu,\"tt_hit_rate\":%.4f,"
+                      "\"allocations\":%llu,\"allocations_per_move\":%.2f,\"mean_depth\":%.2f,"
+                      "\"peak_tree_nodes\":%llu,\"pondered_moves\":%llu,\"ponder_searches\":%llu,"
+                      "\"ponder_nodes\":%llu,\"latency_ns\":{\"min\":%llu,\"mean\":%.0f,"
+                      "\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}}",
+                      first ? "" : ",", BACKEND_NAMES[i], (unsigned long long)moves,
+                      (unsigned long long)nodes, nanos ? nodes * 1e9 / nanos : 0.0,
+                      (unsigned long long)probes, (unsigned long long)hits,
+                      probes ? double(hits) / probes : 0.0,
+                      (unsigned long long)b.allocations.load(),
+                      moves ? double(b.allocations.load()) / moves : 0.0,
+                      moves ? double(b.depthSum.load()) / moves : 0.0, (unsigned long long)b.peakTreeNodes.load(),
+                      (unsigned long long)b.ponderedMoves.load(), (unsigned long long)ponders,
+                      (unsigned long long)b.ponderNodes.load(),
+                      (unsigned long long)h.min(), h.mean(), (unsigned long long)h.percentile(50),
+                      (unsigned long long)h.percentile(90), (unsigned long long)h.percentile(99),
+                      (unsigned long long)h.percentile(99.9), (unsigned long long)h.max());
+        out += buf;
+        first = false;
+    }
+    out += "}}";
+    return out;
+}
@@ -0,0 +1,71 @@
+#include "../include/TranspositionTable.h"
+
+namespace {
+
+// score:16 | depth + 1:8 | flag:8 | bestMove:16
+uint64_t pack(int score, int depth, TTFlag flag, int bestMove) {
+    const int d = depth < 0 ? 0 : (depth > 127 ? 127 : depth);
+    return uint64_t(uint16_t(score)) | uint64_t(d + 1) << 16 | uint64_t(flag) << 24 |
+           uint64_t(uint16_t(bestMove)) << 32;
+}
+
+TTEntry unpack(uint64_t key, uint64_t data) {
+    return TTEntry{key, int16_t(data & 0xFFFF), int8_t(((data >> 16) & 0xFF) - 1),
+                   uint8_t((data >> 24) & 0xFF), int16_t((data >> 32) & 0xFFFF)};
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(int sizeLog2) : log2Size(sizeLog2) {}
+
+size_t TranspositionTable::slot(uint64_t key) const {
+    // Fibonacci hashing spreads the small, structured base-3 keys as well
+    return size_t((key * 0x9E3779B97F4A7C15ull) >> (64 - log2Size));
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& out, TTCounters& count) const {
+    ++count.probes;
+    if (!table) return false;
+
+    const Slot& s = table[slot(key)];
+    const uint64_t data = s.data.load(std::memory_order_relaxed);
+    const uint64_t check = s.check.load(std::memory_order_relaxed);
+    if ((data & 0xFF0000) == 0 || (check ^ data) != key) return false;
+
+    ++count.hits;
+    out = unpack(key, data);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, int score, int depth, TTFlag flag, int bestMove,
+                               TTCounters& count) {
+    reserve();
+
+    Slot& s = table[slot(key)];
+    const uint64_t oldData = s.data.load(std::memory_order_relaxed);
+    if ((oldData & 0xFF0000) == 0) ++count.used;
+    else if ((s.check.load(std::memory_order_relaxed) ^ oldData) != key) ++count.overwrites;
+
+    const uint64_t data = pack(score, depth, flag, bestMove);
+    s.data.store(data, std::memory_order_relaxed);
+    s.check.store(key ^ data, std::memory_order_relaxed);
+    ++count.stores;
+}
+
+void TranspositionTable::reserve() {
+    if (!table) table.reset(new Slot[capacity()]);
+}
+
+void TranspositionTable::clear() {
+    table.reset();
+    counters = TTCounters{};
+}
+
+void TranspositionTable::resize(int newSizeLog2) {
+    log2Size = newSizeLog2;
+    clear();
+}
+
+TTStats TranspositionTable::stats(const TTCounters& count) const {
+    return TTStats{count.probes, count.hits, count.stores, count.overwrites, count.used, capacity()};
+}
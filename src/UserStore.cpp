@@ -0,0 +1,219 @@
+#include "../include/UserStore.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = {'T', 'T', 'U', 'S'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+// Snapshot layout, little endian:
+//   magic[4] version:u32 logOffset:u64 count:u64
+// logOffset is where the log lines the snapshot does not cover start.
+//   count x { nameLen:u16 name passLen:u16 pass }
+
+void putU16(std::string& out, uint16_t v) {
+    out.push_back(char(v & 0xFF));
+    out.push_back(char(v >> 8));
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(char((v >> (8 * i)) & 0xFF));
+}
+
+void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(char((v >> (8 * i)) & 0xFF));
+}
+
+bool validField(const std::string& s) {
+    if (s.empty() || s.size() > 0xFFFF) return false;
+    for (char c : s)
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return false;
+    return true;
+}
+
+} // namespace
+
+UserStore::UserStore(const std::string& logPath, const std::string& snapshotPath)
+    : logPath(logPath), snapshotPath(snapshotPath) {
+    load();
+}
+
+UserStore::~UserStore() {
+    std::lock_guard<std::mutex> guard(lock);
+    log.flush();
+}
+
+UserStore& UserStore::instance() {
+    static UserStore store;
+    return store;
+}
+
+void UserStore::load() {
+    uint64_t offset = 0;
+    if (!loadSnapshot(offset)) {
+        users.clear();
+        offset = 0;
+    }
+    replayLog(offset);
+    log.open(logPath, std::ios::app | std::ios::binary);
+
+    // Hand-edited files may lack the final newline; appends need one
+    std::ifstream in(logPath, std::ios::binary);
+    if (logSize > 0 && in.seekg(-1, std::ios::end) && in.get() != '\n') {
+        log << '\n';
+        ++logSize;
+    }
+}
+
+bool UserStore::loadSnapshot(uint64_t& logOffset) {
+    std::ifstream in(snapshotPath, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    std::vector<char> data(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(data.data(), data.size())) return false;
+
+    size_t pos = 0;
+    auto has = [&](size_t n) { return pos + n <= data.size(); };
+    auto u16 = [&] {
+        uint16_t v = uint16_t(uint8_t(data[pos])) | uint16_t(uint8_t(data[pos + 1])) << 8;
+        pos += 2;
+        return v;
+    };
+    auto u32 = [&] {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= uint32_t(uint8_t(data[pos + i])) << (8 * i);
+        pos += 4;
+        return v;
+    };
+    auto u64 = [&] {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= uint64_t(uint8_t(data[pos + i])) << (8 * i);
+        pos += 8;
+        return v;
+    };
+
+    if (!has(24) || std::memcmp(data.data(), SNAPSHOT_MAGIC, 4) != 0) return false;
+    pos = 4;
+    if (u32() != SNAPSHOT_VERSION) return false;
+    logOffset = u64();
+    uint64_t count = u64();
+
+    // A log shorter than the snapshot claims means it was replaced
+    std::ifstream logIn(logPath, std::ios::binary | std::ios::ate);
+    uint64_t currentLog = logIn ? uint64_t(logIn.tellg()) : 0;
+    if (currentLog < logOffset) return false;
+
+    users.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!has(2)) return false;
+        uint16_t nameLen = u16();
+        if (!has(nameLen + 2)) return false;
+        std::string name(&data[pos], nameLen);
+        pos += nameLen;
+        uint16_t passLen = u16();
+        if (!has(passLen)) return false;
+        users.emplace(std::move(name), std::string(&data[pos], passLen));
+        pos += passLen;
+    }
+    return true;
+}
+
+void UserStore::replayLog(uint64_t fromOffset) {
+    std::ifstream in(logPath, std::ios::binary);
+    if (!in) {
+        logSize = 0;
+        return;
+    }
+    in.seekg(static_cast<std::streamoff>(fromOffset));
+    std::string user, pass;
+    appendsSinceSnapshot = 0; // only the lines the snapshot does not cover
+    while (in >> user >> pass) {
+        users.emplace(user, pass); // first signup of a name wins, as before
+        ++appendsSinceSnapshot;
+    }
+    in.clear();
+    in.seekg(0, std::ios::end);
+    logSize = uint64_t(in.tellg());
+}
+
+// Writes the whole index, which holds every log line written so far
+bool UserStore::writeSnapshot() {
+    std::string out;
+    out.append(SNAPSHOT_MAGIC, 4);
+    putU32(out, SNAPSHOT_VERSION);
+    putU64(out, logSize);
+    putU64(out, users.size());
+    for (const auto& entry : users) {
+        putU16(out, static_cast<uint16_t>(entry.first.size()));
+        out += entry.first;
+        putU16(out, static_cast<uint16_t>(entry.second.size()));
+        out += entry.second;
+    }
+
+    // Write aside and rename, so a crash never leaves a half-written snapshot
+    const std::string tmp = snapshotPath + ".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f.write(out.data(), out.size())) return false;
+    }
+    return std::rename(tmp.c_str(), snapshotPath.c_str()) == 0;
+}
+
+// The log is flushed first so the offset in the snapshot is on disk; the
+// log itself is left alone
+void UserStore::compactLocked() {
+    log.flush();
+    pendingFlush = 0;
+    if (!writeSnapshot()) return;
+    appendsSinceSnapshot = 0;
+}
+
+bool UserStore::contains(const std::string& username) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return users.count(username) != 0;
+}
+
+bool UserStore::check(const std::string& username, const std::string& password) const {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = users.find(username);
+    return it != users.end() && it->second == password;
+}
+
+bool UserStore::add(const std::string& username, const std::string& password) {
+    if (!validField(username) || !validField(password)) return false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    if (!users.emplace(username, password).second) return false;
+
+    log << username << ' ' << password << '\n';
+    logSize += username.size() + password.size() + 2;
+    if (++pendingFlush >= flushEvery) {
+        log.flush();
+        pendingFlush = 0;
+    }
+    // The tail must also grow to a quarter of the index before the next
+    // snapshot, so rewriting the index stays amortized O(1) per signup
+    ++appendsSinceSnapshot;
+    if (compactEvery > 0 && appendsSinceSnapshot >= compactEvery &&
+        size_t(appendsSinceSnapshot) >= users.size() / 4)
+        compactLocked();
+    return true;
+}
+
+void UserStore::flush() {
+    std::lock_guard<std::mutex> guard(lock);
+    log.flush();
+    pendingFlush = 0;
+}
+
+void UserStore::compact() {
+    std::lock_guard<std::mutex> guard(lock);
+    compactLocked();
+}
+
+size_t UserStore::size() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return users.size();
+}